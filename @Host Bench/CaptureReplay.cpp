@@ -0,0 +1,390 @@
+//==================================================================================
+//==================================================================================
+// File: CaptureReplay.cpp
+// Description: Replays a mixer capture (cCapture.h, firmware or HostBench
+//              --capture) through cMixer and checks each block bit for bit.
+//
+// Each block record gives the TX request and everything the interrupts
+// handed to the mixer before it: the replay applies them through the public
+// mixer API (markInput, resyncInput, restartOutput, setSourceRate, the
+// parameter setters, receivers returning the recorded DMA positions) and
+// mixes the block with pullSamples. The replayed mixer records its own
+// blocks, which must be identical to the captured ones, hashes included:
+// the first block that differs is reported.
+//
+// The output hash is only checked while the inputs outside the sample mask
+// are muted (their frames were not recorded).
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cMixer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace Dad;
+
+// -----------------------------------------------------------------------------
+// HAL stub storage
+// -----------------------------------------------------------------------------
+extern "C" {
+uint32_t SystemCoreClock = 480000000;
+DWT_Type HostDWT;
+CoreDebug_Type HostCoreDebug;
+}
+
+//**********************************************************************************
+// cRecordReader
+// Little endian values from the capture, past the end reads return 0 and
+// set the error flag
+//**********************************************************************************
+class cRecordReader
+{
+public:
+    cRecordReader(const std::vector<uint8_t>& data) : m_Data(data), m_Position(0), m_Error(false) {}
+
+    uint8_t Get8()
+    {
+        if (m_Position >= m_Data.size())
+        {
+            m_Error = true;
+            return 0;
+        }
+        return m_Data[m_Position++];
+    }
+    uint16_t Get16() { uint16_t v = Get8(); return v | static_cast<uint16_t>(Get8() << 8); }
+    uint32_t Get32() { uint32_t v = Get16(); return v | (static_cast<uint32_t>(Get16()) << 16); }
+    float GetFloat()
+    {
+        uint32_t bits = Get32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    int32_t GetSample24() { uint32_t v = Get16(); return static_cast<int32_t>(v | (static_cast<uint32_t>(Get8()) << 16)); }
+
+    size_t getPosition() const { return m_Position; }
+    bool isEnd() const { return m_Position >= m_Data.size(); }
+    bool hasError() const { return m_Error; }
+
+private:
+    const std::vector<uint8_t>& m_Data;
+    size_t m_Position;
+    bool m_Error;
+};
+
+//**********************************************************************************
+// cReplayStream
+// Receiver returning the recorded DMA position of the block, ring written
+// from the recorded frames
+//**********************************************************************************
+class cReplayStream : public cInputStream
+{
+public:
+    cReplayStream() : m_WriteIndex(CAPTURE_MUTED) { std::memset(m_Ring, 0, sizeof(m_Ring)); }
+
+    uint32_t getRemaining() const override { return CIRCULAR_BUFFER_SAMPLES - m_WriteIndex * 2U; }
+    bool isValid() const override { return m_WriteIndex != CAPTURE_MUTED; }
+
+    uint16_t m_WriteIndex;                    // Recorded ring frame written next
+    int32_t m_Ring[CIRCULAR_BUFFER_SAMPLES];  // Mixer input ring
+};
+
+// -----------------------------------------------------------------------------
+// 24-bit stereo WAV at the output rate (sizes patched by WavClose)
+// -----------------------------------------------------------------------------
+static void WavPut(FILE* pFile, uint32_t value, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++) std::fputc(static_cast<int>((value >> (8 * i)) & 0xFF), pFile);
+}
+
+static void WavOpen(FILE* pFile)
+{
+    std::fwrite("RIFF\0\0\0\0WAVEfmt ", 1, 16, pFile);
+    WavPut(pFile, 16, 4);
+    WavPut(pFile, 1, 2);                        // PCM
+    WavPut(pFile, 2, 2);                        // Stereo
+    WavPut(pFile, OUTPUT_SAMPLE_RATE, 4);
+    WavPut(pFile, OUTPUT_SAMPLE_RATE * 6, 4);   // Bytes per second
+    WavPut(pFile, 6, 2);                        // Bytes per frame
+    WavPut(pFile, 24, 2);
+    std::fwrite("data\0\0\0\0", 1, 8, pFile);
+}
+
+static void WavClose(FILE* pFile)
+{
+    uint32_t size = static_cast<uint32_t>(std::ftell(pFile));
+    std::fseek(pFile, 4, SEEK_SET);
+    WavPut(pFile, size - 8, 4);
+    std::fseek(pFile, 40, SEEK_SET);
+    WavPut(pFile, size - 44, 4);
+    std::fclose(pFile);
+}
+
+static void WavWrite(FILE* pFile, const int32_t* pSamples, uint32_t nbSamples)
+{
+    for (uint32_t i = 0; i < nbSamples; i++)
+    {
+        int32_t v = std::max(-8388608, std::min(8388607, pSamples[i]));
+        WavPut(pFile, static_cast<uint32_t>(v), 3);
+    }
+}
+
+static void Usage()
+{
+    std::printf(
+        "CaptureReplay FILE [options]\n"
+        "  --wav FILE       replayed output (24-bit stereo, 48 kHz)\n"
+        "  --csv FILE       drift loop state per block and input\n"
+        "  --keep-going     replay to the end after a divergence\n"
+        "exit status 0: bit-exact, 1: divergence, 2: invalid capture\n");
+}
+
+// =============================================================================
+// Entry point
+// =============================================================================
+int main(int argc, char** argv)
+{
+    const char* pCaptureName = nullptr;
+    const char* pWavName = nullptr;
+    const char* pCsvName = nullptr;
+    bool keepGoing = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto need = [&]() { if (!val) { Usage(); std::exit(2); } i++; return val; };
+
+        if      (!std::strcmp(arg, "--wav"))        { pWavName = need(); }
+        else if (!std::strcmp(arg, "--csv"))        { pCsvName = need(); }
+        else if (!std::strcmp(arg, "--keep-going")) { keepGoing = true; }
+        else if ((arg[0] != '-') && !pCaptureName)  { pCaptureName = arg; }
+        else { Usage(); return 2; }
+    }
+    if (!pCaptureName) { Usage(); return 2; }
+
+    // -------------------------------------------------------------------------
+    // Capture and header
+    // -------------------------------------------------------------------------
+    std::vector<uint8_t> data;
+    FILE* pFile = std::fopen(pCaptureName, "rb");
+    if (!pFile) { std::perror(pCaptureName); return 2; }
+    uint8_t chunk[65536];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), pFile)) != 0) data.insert(data.end(), chunk, chunk + count);
+    std::fclose(pFile);
+
+    cRecordReader reader(data);
+    char magic[4];
+    for (char& c : magic) c = static_cast<char>(reader.Get8());
+    uint8_t version = reader.Get8();
+    uint8_t nbInputs = reader.Get8();
+    uint8_t profile = reader.Get8();
+    uint8_t sampleMask = reader.Get8();
+    uint16_t txFrames = reader.Get16();
+    uint16_t ringSize = reader.Get16();
+    uint32_t outputRate = reader.Get32();
+    uint32_t coreClock = reader.Get32();
+
+    if (reader.hasError() || std::memcmp(magic, "DCAP", 4) || (version != CAPTURE_VERSION))
+    {
+        std::printf("%s: not a capture (version %u)\n", pCaptureName, CAPTURE_VERSION);
+        return 2;
+    }
+    if ((nbInputs != cAudioMixer::NB_INPUTS) || (txFrames != TX_NB_FRAMES) ||
+        (ringSize != CIRCULAR_BUFFER_SIZE) || (outputRate != OUTPUT_SAMPLE_RATE))
+    {
+        std::printf("%s: recorded with %u inputs, AUDIO_PROFILE %u (TX %u frames, ring %u): "
+                    "rebuild with the same settings\n", pCaptureName, nbInputs, profile, txFrames, ringSize);
+        return 2;
+    }
+
+    // -------------------------------------------------------------------------
+    // Mixer in its initial state, at the recorded core clock, re-recording
+    // its blocks
+    // -------------------------------------------------------------------------
+    SystemCoreClock = coreClock;
+    auto pMixer = std::make_unique<cAudioMixer>();
+    std::vector<std::unique_ptr<cReplayStream>> streams;
+    for (uint8_t ch = 0; ch < nbInputs; ch++)
+    {
+        streams.push_back(std::make_unique<cReplayStream>());
+        pMixer->attachInput(ch, streams[ch]->m_Ring, streams[ch].get());
+    }
+
+    std::vector<uint8_t> replayRing(1 << 20);
+    std::vector<uint8_t> replayed(replayRing.size());
+    cCapture replay;
+    replay.Init(replayRing.data(), static_cast<uint32_t>(replayRing.size()), sampleMask);
+    replay.Start();
+    pMixer->attachCapture(&replay);
+    replay.Read(replayed.data(), CAPTURE_HEADER_SIZE);
+
+    FILE* pWav = pWavName ? std::fopen(pWavName, "wb") : nullptr;
+    if (pWavName && !pWav) { std::perror(pWavName); return 2; }
+    if (pWav) WavOpen(pWav);
+    FILE* pCsv = pCsvName ? std::fopen(pCsvName, "w") : nullptr;
+    if (pCsvName && !pCsv) { std::perror(pCsvName); return 2; }
+    if (pCsv)
+    {
+        std::fprintf(pCsv, "time_s");
+        for (uint8_t ch = 0; ch < nbInputs; ch++) std::fprintf(pCsv, ",lock_%u,drift_%u,fill_%u,loop_error_%u", ch, ch, ch, ch);
+        std::fprintf(pCsv, "\n");
+    }
+
+    std::printf("%s: %u inputs, profile %u, core clock %u Hz, frames of inputs 0x%02X\n",
+                pCaptureName, nbInputs, profile, coreClock, sampleMask);
+
+    // -------------------------------------------------------------------------
+    // Blocks
+    // -------------------------------------------------------------------------
+    static const char* types[] = {"underrun", "overrun", "resync"};
+    const uint8_t allInputs = static_cast<uint8_t>((1U << nbInputs) - 1);
+    uint8_t unmutedInputs = 0;            // Inputs with a valid stream so far
+    uint64_t nbBlocks = 0, nbDiverged = 0, firstDiverged = 0;
+    uint32_t eventRead = 0;
+    int32_t samples[TX_BUFFER_SIZE];
+    int status = 0;
+
+    while (!reader.isEnd())
+    {
+        size_t recordStart = reader.getPosition();
+        if (reader.Get8() != CAPTURE_BLOCK)
+        {
+            std::printf("block %llu: invalid record at offset %zu\n", static_cast<unsigned long long>(nbBlocks), recordStart);
+            status = 2;
+            break;
+        }
+        uint8_t flags = reader.Get8();
+        uint32_t timestamp = reader.Get32();
+        for (uint8_t ch = 0; ch < nbInputs; ch++)
+        {
+            streams[ch]->m_WriteIndex = reader.Get16();
+            if (streams[ch]->m_WriteIndex != CAPTURE_MUTED) unmutedInputs |= static_cast<uint8_t>(1U << ch);
+        }
+
+        if (flags & CAPTURE_TX_RESTART) pMixer->restartOutput();
+        if (flags & CAPTURE_PARAMS)
+        {
+            for (uint8_t ch = 0; ch < nbInputs; ch++) pMixer->setGain(ch, reader.GetFloat());
+            pMixer->setGainMaster(reader.GetFloat());
+            for (uint8_t ch = 0; ch < nbInputs; ch++)
+            {
+                eInterpolation interp = static_cast<eInterpolation>(reader.Get8());
+                if (!pMixer->setInterpolation(ch, interp))
+                {
+                    std::printf("block %llu: input %u kernel %u over the host budget\n",
+                                static_cast<unsigned long long>(nbBlocks), ch, static_cast<uint8_t>(interp));
+                }
+            }
+        }
+
+        for (uint8_t ch = 0; ch < nbInputs; ch++)
+        {
+            uint8_t inputFlags = reader.Get8();
+            if (inputFlags & CAPTURE_RESYNC) pMixer->resyncInput(ch, reader.Get32());
+            if (inputFlags & CAPTURE_SOURCE_RATE) pMixer->setSourceRate(ch, reader.Get32());
+            if (inputFlags & CAPTURE_FRAMES)
+            {
+                uint32_t frame = reader.Get16();
+                uint32_t nbFrames = reader.Get16();
+                for (uint32_t i = 0; i < nbFrames; i++, frame++)
+                {
+                    int32_t* pFrame = &streams[ch]->m_Ring[(frame & CIRCULAR_BUFFER_MASK) * 2];
+                    pFrame[0] = reader.GetSample24();
+                    pFrame[1] = reader.GetSample24();
+                }
+            }
+            for (uint32_t i = 0; i < (inputFlags >> CAPTURE_MARK_SHIFT); i++)
+            {
+                uint32_t frameIndex = reader.Get16();
+                pMixer->markInput(ch, frameIndex, reader.Get32());
+            }
+        }
+        reader.Get32();                   // Hashes, compared with the replayed record
+        reader.Get32();
+        if (reader.hasError())
+        {
+            std::printf("block %llu: capture truncated\n", static_cast<unsigned long long>(nbBlocks));
+            break;
+        }
+
+        pMixer->pullSamples(samples, timestamp);
+        if (pWav) WavWrite(pWav, samples, TX_BUFFER_SIZE);
+
+        // Replayed record against the captured one, output hash (before the
+        // state hash) skipped when unrecorded inputs played
+        size_t size = reader.getPosition() - recordStart;
+        uint32_t replayedSize = replay.Read(replayed.data(), static_cast<uint32_t>(replayed.size()));
+        const uint8_t* pCaptured = &data[recordStart];
+        bool outputChecked = ((unmutedInputs & ~sampleMask & allInputs) == 0);
+        bool same = (replayedSize == size) &&
+                    !std::memcmp(replayed.data(), pCaptured, size - 8) &&
+                    !std::memcmp(&replayed[size - 4], pCaptured + size - 4, 4) &&
+                    (!outputChecked || !std::memcmp(&replayed[size - 8], pCaptured + size - 8, 4));
+        if (!same)
+        {
+            if (nbDiverged == 0)
+            {
+                firstDiverged = nbBlocks;
+                const char* part = "record";
+                if ((replayedSize == size) && !std::memcmp(replayed.data(), pCaptured, size - 8))
+                {
+                    part = std::memcmp(&replayed[size - 4], pCaptured + size - 4, 4) ? "drift state" : "output";
+                }
+                std::printf("block %llu (%.6f s): %s differs\n", static_cast<unsigned long long>(nbBlocks),
+                            static_cast<double>(nbBlocks) * TX_NB_FRAMES / OUTPUT_SAMPLE_RATE, part);
+            }
+            nbDiverged++;
+            status = 1;
+        }
+
+        // Stream events, as the mixer logged them
+        for (; eventRead != pMixer->getEventCount(); eventRead++)
+        {
+            sStreamEvent e;
+            if (!pMixer->getEvent(eventRead, e)) continue;
+            std::printf("  input %u %-8s at %.4f s: fill %.2f, loop error %.2f, ratio %.6f, %u frames\n",
+                        e.Input, types[static_cast<uint8_t>(e.Type)], static_cast<double>(e.OutDate) / OUTPUT_SAMPLE_RATE,
+                        e.FillLevel, e.LoopError, e.DriftFactor, e.Frames);
+        }
+
+        if (pCsv)
+        {
+            std::fprintf(pCsv, "%.6f", static_cast<double>(nbBlocks + 1) * TX_NB_FRAMES / OUTPUT_SAMPLE_RATE);
+            for (uint8_t ch = 0; ch < nbInputs; ch++)
+            {
+                std::fprintf(pCsv, ",%u,%.9f,%.4f,%.4f", static_cast<uint8_t>(pMixer->getLockState(ch)),
+                             pMixer->getDriftFactor(ch), pMixer->getBufferAge(ch), pMixer->getLoopError(ch));
+            }
+            std::fprintf(pCsv, "\n");
+        }
+
+        nbBlocks++;
+        if ((nbDiverged != 0) && !keepGoing) break;
+    }
+
+    if (pWav) WavClose(pWav);
+    if (pCsv) std::fclose(pCsv);
+
+    double seconds = static_cast<double>(nbBlocks) * TX_NB_FRAMES / OUTPUT_SAMPLE_RATE;
+    const char* checked = ((unmutedInputs & ~sampleMask & allInputs) == 0) ? "output and drift state" : "drift state";
+    if (nbDiverged == 0)
+    {
+        std::printf("%llu blocks (%.3f s) replayed, %s bit-exact\n", static_cast<unsigned long long>(nbBlocks), seconds, checked);
+    }
+    else
+    {
+        std::printf("%llu blocks (%.3f s) replayed, %llu differ from block %llu\n", static_cast<unsigned long long>(nbBlocks),
+                    seconds, static_cast<unsigned long long>(nbDiverged), static_cast<unsigned long long>(firstDiverged));
+    }
+    return status;
+}
+
+//***End of file**************************************************************
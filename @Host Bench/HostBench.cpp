@@ -0,0 +1,893 @@
+//==================================================================================
+//==================================================================================
+// File: HostBench.cpp
+// Description: Host-native benchmark of cMixer. Drives a simulated receiver DMA
+//              and pullSamples from a clock model and reports audio quality,
+//              buffer fill level, lock time and processing cost.
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cMixer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Dad;
+
+// -----------------------------------------------------------------------------
+// HAL stub storage
+// -----------------------------------------------------------------------------
+extern "C" {
+uint32_t SystemCoreClock = 480000000;
+DWT_Type HostDWT;
+CoreDebug_Type HostCoreDebug;
+}
+
+// =============================================================================
+// Scenario and results
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+// Simulated source and analysis settings
+// -----------------------------------------------------------------------------
+struct sScenario
+{
+    double         Rate      = 44100.0;     // Nominal source rate (Hz)
+    double         Ppm       = 0.0;         // Source clock offset (ppm)
+    double         JitterUs  = 0.0;         // DMA callback latency (0 to us)
+    double         Seconds   = 6.0;         // Simulated duration
+    double         Analysis  = 1.0;         // Analysis window at the end (s)
+    double         ToneHz    = 997.0;       // Test tone frequency
+    double         LevelDb   = -6.0;        // Test tone level (dBFS)
+    double         LockPpm   = 50.0;        // Lock tolerance on the ratio
+    double         LockFrames = 4.0;        // Lock tolerance on the loop fill error
+    eInterpolation Interp    = eInterpolation::Sinc32;
+    bool           Hint      = false;       // Report the nominal rate (as cSPDIF_RX does)
+    bool           Deferred  = false;       // Queue / Process path of the firmware
+    double         Glitch    = 0.0;         // RX DMA error and restart time (s, 0 = none)
+    double         Switch    = 0.0;         // Kernel switch time (s, 0 = none)
+    eInterpolation SwitchInterp = eInterpolation::Sinc32;  // Kernel selected at Switch
+    uint32_t       Seed      = 1;
+};
+
+// -----------------------------------------------------------------------------
+// Measured values
+// -----------------------------------------------------------------------------
+struct sResult
+{
+    bool   Locked     = false;   // Lock reached before the analysis window
+    double StartTime  = -1.0;    // First TX block with the input synchronized (s)
+    double LockTime   = 0.0;     // Time after which the loop stays in tolerance (s)
+    double ThdnDb     = 0.0;     // THD+N over the analysis window (dB)
+    double GainDb     = 0.0;     // Tone gain (output / input level, dB)
+    double FillMin    = 0.0;     // Fill level over the analysis window (frames)
+    double FillMean   = 0.0;
+    double FillMax    = 0.0;
+    double RatioPpm   = 0.0;     // Mean ratio error over the analysis window (ppm)
+    double NsPerFrame = 0.0;     // pullSamples cost per output frame (ns)
+    double RecoveryMs = -1.0;    // RX restart to first mixed block (ms, -1 = none)
+    double StepRatio  = 0.0;     // Largest output step / largest tone step (analysis window)
+    std::vector<sStreamEvent> Events;  // Underruns, overruns and resyncs of the input
+};
+
+// =============================================================================
+// Sine fit (IEEE 1057 four parameters)
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+// Solves a small linear system in place (Gaussian elimination with pivoting)
+// -----------------------------------------------------------------------------
+template <int N>
+static bool Solve(double (&a)[N][N], double (&b)[N])
+{
+    for (int c = 0; c < N; c++)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < N; r++)
+        {
+            if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+        }
+        if (a[pivot][c] == 0.0) return false;
+        std::swap(a[c], a[pivot]);
+        std::swap(b[c], b[pivot]);
+
+        for (int r = c + 1; r < N; r++)
+        {
+            double k = a[r][c] / a[c][c];
+            for (int j = c; j < N; j++) a[r][j] -= k * a[c][j];
+            b[r] -= k * b[c];
+        }
+    }
+    for (int c = N - 1; c >= 0; c--)
+    {
+        for (int j = c + 1; j < N; j++) b[c] -= a[c][j] * b[j];
+        b[c] /= a[c][c];
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Fits A.cos(wt) + B.sin(wt) + C, refining w. Returns the fit amplitude and
+// the RMS of the residual (noise + distortion).
+// -----------------------------------------------------------------------------
+static void SineFit(const std::vector<double>& x, double fs, double freq, double& amplitude, double& residualRms)
+{
+    double w = 2.0 * M_PI * freq / fs;
+    double A = 0.0, B = 0.0, C = 0.0;
+    const size_t n = x.size();
+    const double tMid = (n - 1) * 0.5;
+
+    for (int iter = 0; iter < 8; iter++)
+    {
+        double ata[4][4] = {};
+        double atb[4] = {};
+        const int nbParams = (iter == 0) ? 3 : 4;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            double t = i - tMid;
+            double c = std::cos(w * t), s = std::sin(w * t);
+            double col[4] = {c, s, 1.0, t * (B * c - A * s)};
+            for (int r = 0; r < nbParams; r++)
+            {
+                for (int k = 0; k < nbParams; k++) ata[r][k] += col[r] * col[k];
+                atb[r] += col[r] * x[i];
+            }
+        }
+        if (nbParams == 3)
+        {
+            double a3[3][3], b3[3];
+            for (int r = 0; r < 3; r++) { b3[r] = atb[r]; for (int k = 0; k < 3; k++) a3[r][k] = ata[r][k]; }
+            if (!Solve(a3, b3)) break;
+            A = b3[0]; B = b3[1]; C = b3[2];
+        }
+        else
+        {
+            if (!Solve(ata, atb)) break;
+            A = atb[0]; B = atb[1]; C = atb[2];
+            w += atb[3];
+        }
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double t = i - tMid;
+        double e = x[i] - (A * std::cos(w * t) + B * std::sin(w * t) + C);
+        sum += e * e;
+    }
+    amplitude = std::sqrt(A * A + B * B);
+    residualRms = std::sqrt(sum / n);
+}
+
+// =============================================================================
+// Simulation
+// =============================================================================
+
+//**********************************************************************************
+// cSimStream
+// Receiver whose circular DMA writes a test tone into the input ring, one
+// sample at a time at the source rate, and timestamps each ring half
+//**********************************************************************************
+class cSimStream : public cInputStream
+{
+public:
+    cSimStream(double rate, double toneHz, double amplitude)
+        : m_Rate(rate), m_Step(2.0 * M_PI * toneHz / rate), m_Amplitude(amplitude), m_Written(0), m_Start(0)
+    {
+        std::memset(m_Ring, 0, sizeof(m_Ring));
+    }
+
+    uint32_t getRemaining() const override
+    {
+        return CIRCULAR_BUFFER_SAMPLES - static_cast<uint32_t>((m_Written - m_Start) % CIRCULAR_BUFFER_SAMPLES);
+    }
+    bool isValid() const override { return true; }
+
+    // DMA restarted by the error callback: the ring is written from its start
+    void Restart() { m_Start = m_Written; }
+
+    // Writes the samples received up to time t (s), calls
+    // onHalf(frame index, time) at each ring half
+    template <typename F>
+    void Run(double t, F onHalf)
+    {
+        uint64_t target = static_cast<uint64_t>(t * m_Rate * 2.0);
+        while (m_Written < target)
+        {
+            double v = m_Amplitude * std::sin(m_Step * static_cast<double>(m_Written / 2));
+            uint64_t position = m_Written - m_Start;
+            m_Ring[position % CIRCULAR_BUFFER_SAMPLES] = static_cast<int32_t>(std::lround(v * COEF_DENORMALIZE)) & 0xFFFFFF;
+            m_Written++;
+            position++;
+            if ((position % (CIRCULAR_BUFFER_SAMPLES / 2)) == 0)
+            {
+                onHalf(static_cast<uint32_t>(position % CIRCULAR_BUFFER_SAMPLES) / 2, m_Written / (m_Rate * 2.0));
+            }
+        }
+    }
+
+    int32_t m_Ring[CIRCULAR_BUFFER_SAMPLES];  // DMA target
+
+private:
+    double   m_Rate;        // Source frame rate (Hz)
+    double   m_Step;        // Tone phase step per frame
+    double   m_Amplitude;   // Tone amplitude
+    uint64_t m_Written;     // Samples written
+    uint64_t m_Start;       // Samples written at the DMA start (NDTR = ring size - position % ring size)
+};
+
+// -----------------------------------------------------------------------------
+// DWT cycle counter value at simulated time t (s)
+// -----------------------------------------------------------------------------
+static uint32_t CyclesAt(double t)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(t * SystemCoreClock));
+}
+
+// -----------------------------------------------------------------------------
+// Writes the published capture records to the file
+// -----------------------------------------------------------------------------
+static void DrainCapture(cCapture& capture, FILE* pFile)
+{
+    uint8_t chunk[4096];
+    uint32_t count;
+    while ((count = capture.Read(chunk, sizeof(chunk))) != 0)
+    {
+        std::fwrite(chunk, 1, count, pFile);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Runs one scenario on mixer input 0, optionally writing the fill level
+// trajectory (one line per ms) to pFillCsv and the block records, with the
+// frames of input 0, to pCaptureFile (CaptureReplay)
+// -----------------------------------------------------------------------------
+static sResult RunScenario(const sScenario& sc, FILE* pFillCsv, FILE* pCaptureFile = nullptr)
+{
+    sResult res;
+    const double fin = sc.Rate * (1.0 + sc.Ppm * 1e-6);
+    const double ratio = fin / OUTPUT_SAMPLE_RATE;
+    const double txPeriod = static_cast<double>(TX_NB_FRAMES) / OUTPUT_SAMPLE_RATE;
+    const double jitter = std::min(sc.JitterUs * 1e-6, 0.4 * txPeriod);
+    const double amplitude = std::pow(10.0, sc.LevelDb / 20.0);
+    const double analysisStart = sc.Seconds - sc.Analysis;
+
+    auto pMixer = std::make_unique<cAudioMixer>();
+    auto pStream = std::make_unique<cSimStream>(fin, sc.ToneHz, amplitude);
+    pMixer->attachInput(0, pStream->m_Ring, pStream.get());
+    pMixer->setInterpolation(0, sc.Interp);
+    if (sc.Hint) pMixer->setSourceRate(0, static_cast<uint32_t>(sc.Rate));
+
+    std::vector<uint8_t> captureRing;
+    cCapture capture;
+    if (pCaptureFile)
+    {
+        captureRing.resize(1 << 20);
+        capture.Init(captureRing.data(), static_cast<uint32_t>(captureRing.size()), 0x01);
+        capture.Start();
+        pMixer->attachCapture(&capture);
+    }
+
+    std::mt19937 rng(sc.Seed);
+    std::uniform_real_distribution<double> jitterDist(0.0, jitter);
+
+    int32_t txBlock[TX_BUFFER_SIZE];
+    uint64_t txIndex = 0;
+    bool glitched = (sc.Glitch <= 0.0);
+    bool switched = (sc.Switch <= 0.0);
+    double lastOutOfLock = 0.0, nextCsv = 0.0;
+    double fillSmooth = 0.0;                  // Fill level averaged over the block beat
+    const double smooth = txPeriod / 0.005;   // 5ms time constant
+    double fillSum = 0.0, ratioSum = 0.0;
+    uint64_t fillCount = 0;
+    uint64_t pullNs = 0;
+    std::vector<double> output;
+    output.reserve(static_cast<size_t>(sc.Analysis * OUTPUT_SAMPLE_RATE) + TX_NB_FRAMES);
+    res.FillMin = 1e9;
+    res.FillMax = -1e9;
+
+    if (pFillCsv) std::fprintf(pFillCsv, "time_s,fill_frames,fill_smooth,ratio_error_ppm\n");
+
+    for (;;)
+    {
+        double nextTx = (txIndex + 1) * txPeriod;
+        if (nextTx > sc.Seconds) break;
+
+        // TX callback, after the interrupt latency: the receiver DMA has
+        // written the ring up to that time, RX half callbacks included
+        double callback = nextTx + jitterDist(rng);
+        auto onHalf = [&](uint32_t frameIndex, double t)
+        {
+            pMixer->markInput(0, frameIndex, CyclesAt(t + jitterDist(rng)));
+        };
+        if (!glitched && (callback >= sc.Glitch))
+        {
+            // RX DMA error: the callback restarts the stream at once
+            pStream->Run(sc.Glitch, onHalf);
+            pMixer->resyncInput(0, CyclesAt(sc.Glitch));
+            pStream->Restart();
+            glitched = true;
+        }
+        pStream->Run(callback, onHalf);
+        if (!switched && (callback >= sc.Switch))
+        {
+            pMixer->setInterpolation(0, sc.SwitchInterp);  // CC_INTERP
+            switched = true;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        if (sc.Deferred)
+        {
+            // TX callback then audio task run
+            pMixer->fetchSamples(txBlock, CyclesAt(callback));
+            pMixer->Process();
+        }
+        else
+        {
+            pMixer->pullSamples(txBlock, CyclesAt(callback));
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        pullNs += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        txIndex++;
+        if (pCaptureFile) DrainCapture(capture, pCaptureFile);
+        if ((res.StartTime < 0.0) && (pMixer->getLockState(0) != eLockState::NoSync)) res.StartTime = nextTx;
+
+        double drift = pMixer->getDriftFactor(0);
+        double fill = pMixer->getBufferAge(0);
+        double ratioErr = (drift != 0.0) ? (drift / ratio - 1.0) * 1e6 : 1e6;
+        fillSmooth += (fill - fillSmooth) * smooth;
+
+        if ((std::fabs(ratioErr) > sc.LockPpm) || (std::fabs(pMixer->getLoopError(0)) > sc.LockFrames))
+        {
+            lastOutOfLock = nextTx;
+        }
+
+        if (pFillCsv && (nextTx >= nextCsv))
+        {
+            std::fprintf(pFillCsv, "%.4f,%.4f,%.4f,%.3f\n", nextTx, fill, fillSmooth, ratioErr);
+            nextCsv += 0.001;
+        }
+
+        if (nextTx > analysisStart)
+        {
+            for (uint32_t i = 0; i < TX_BUFFER_SIZE; i += 2)
+            {
+                output.push_back(static_cast<double>(txBlock[i]) / COEF_DENORMALIZE);
+            }
+            res.FillMin = std::min(res.FillMin, fill);
+            res.FillMax = std::max(res.FillMax, fill);
+            fillSum += fill;
+            ratioSum += ratioErr;
+            fillCount++;
+        }
+    }
+
+    res.LockTime = lastOutOfLock;
+    res.Locked = lastOutOfLock < analysisStart;
+    res.FillMean = fillCount ? fillSum / fillCount : 0.0;
+    res.RatioPpm = fillCount ? ratioSum / fillCount : 0.0;
+    res.NsPerFrame = txIndex ? static_cast<double>(pullNs) / (txIndex * TX_NB_FRAMES) : 0.0;
+    if (pMixer->getResyncCount(0) != 0)
+    {
+        res.RecoveryMs = 1000.0 * pMixer->getRecoveryCycles(0) / SystemCoreClock;
+    }
+    for (uint32_t i = 0; i < pMixer->getEventCount(); i++)
+    {
+        sStreamEvent event;
+        if (pMixer->getEvent(i, event)) res.Events.push_back(event);
+    }
+
+    double fitAmplitude = 0.0, residual = 0.0;
+    if (!output.empty())
+    {
+        SineFit(output, OUTPUT_SAMPLE_RATE, sc.ToneHz, fitAmplitude, residual);
+    }
+    res.GainDb = (fitAmplitude > 0.0) ? 20.0 * std::log10(fitAmplitude / amplitude) : -999.0;
+    res.ThdnDb = (fitAmplitude > 0.0 && residual > 0.0) ? 20.0 * std::log10(residual / (fitAmplitude / std::sqrt(2.0))) : -999.0;
+
+    // A skip or repeat of the tone shows as a step larger than its slope
+    // (source amplitude: the fit of a window holding a skip is meaningless)
+    double maxStep = 0.0;
+    for (size_t i = 1; i < output.size(); i++) maxStep = std::max(maxStep, std::fabs(output[i] - output[i - 1]));
+    double toneStep = 2.0 * amplitude * std::sin(M_PI * sc.ToneHz / OUTPUT_SAMPLE_RATE);
+    res.StepRatio = (toneStep > 0.0) ? maxStep / toneStep : 0.0;
+    return res;
+}
+
+// =============================================================================
+// Reports
+// =============================================================================
+
+static const char* InterpName(eInterpolation interp)
+{
+    switch (interp)
+    {
+        case eInterpolation::Linear: return "linear";
+        case eInterpolation::Cubic:  return "cubic";
+        case eInterpolation::Sinc16: return "sinc16";
+        case eInterpolation::Sinc32: return "sinc32";
+        case eInterpolation::Sinc64: return "sinc64";
+        default: return "?";
+    }
+}
+
+static bool ParseInterp(const char* name, eInterpolation& interp)
+{
+    for (uint8_t k = 0; k < NB_INTERPOLATIONS; k++)
+    {
+        if (std::strcmp(name, InterpName(static_cast<eInterpolation>(k))) == 0)
+        {
+            interp = static_cast<eInterpolation>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Build profile: block sizes, interrupt rate and nominal latency at 48 kHz
+// (ring target age + queued TX blocks + DMA half being played). Each
+// receiver only interrupts at its ring halves.
+// -----------------------------------------------------------------------------
+static void PrintProfile()
+{
+    static const char* names[] = {"ultra-low-latency", "balanced", "low-cpu"};
+    const double rate = 48000.0;
+    double irqRx = rate / RX_MARK_FRAMES;
+    double irqTx = static_cast<double>(OUTPUT_SAMPLE_RATE) / TX_NB_FRAMES;
+    double latencyMs = 1000.0 * (FILL_TARGET / rate + (TX_QUEUE_PREFILL + 1) * TX_NB_FRAMES / static_cast<double>(OUTPUT_SAMPLE_RATE));
+
+    std::printf("profile %s: TX %u frames, ring %u, irq/s %.0f (3 x RX %.0f + TX %.0f + PendSV %.0f), latency %.2f ms @48k\n",
+                names[AUDIO_PROFILE], TX_NB_FRAMES, CIRCULAR_BUFFER_SIZE,
+                3.0 * irqRx + 2.0 * irqTx, irqRx, irqTx, irqTx, latencyMs);
+}
+
+static void PrintHeader()
+{
+    std::printf("%-7s %8s %8s %8s %7s %8s %9s %8s %8s %8s %9s %8s\n",
+                "kernel", "rate", "ppm", "start_ms", "lock_s", "thdn_dB", "gain_dB",
+                "fill_min", "fill_avg", "fill_max", "ratio_ppm", "ns/frame");
+}
+
+static void PrintResult(const sScenario& sc, const sResult& r)
+{
+    char lock[16];
+    if (r.Locked) std::snprintf(lock, sizeof(lock), "%7.3f", r.LockTime);
+    else          std::snprintf(lock, sizeof(lock), "%7s", "none");
+    std::printf("%-7s %8.0f %8.1f %8.2f %s %8.1f %9.4f %8.2f %8.2f %8.2f %9.2f %8.1f\n",
+                InterpName(sc.Interp), sc.Rate, sc.Ppm, r.StartTime * 1000.0, lock, r.ThdnDb, r.GainDb,
+                r.FillMin, r.FillMean, r.FillMax, r.RatioPpm, r.NsPerFrame);
+    if (sc.Glitch > 0.0)
+    {
+        if (r.RecoveryMs >= 0.0) std::printf("        RX restart at %.3f s, mixed again after %.2f ms\n", sc.Glitch, r.RecoveryMs);
+        else                     std::printf("        RX restart at %.3f s, not recovered\n", sc.Glitch);
+    }
+    static const char* types[] = {"underrun", "overrun", "resync"};
+    for (const sStreamEvent& e : r.Events)
+    {
+        std::printf("        %-8s at %.4f s: fill %.2f, loop error %.2f, ratio %.6f, %u frames\n",
+                    types[static_cast<uint8_t>(e.Type)], static_cast<double>(e.OutDate) / OUTPUT_SAMPLE_RATE,
+                    e.FillLevel, e.LoopError, e.DriftFactor, e.Frames);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Passband ripple: tone gain over a frequency sweep at the scenario rate
+// -----------------------------------------------------------------------------
+static void RunSweep(sScenario sc)
+{
+    static const double freqs[] = {20, 50, 100, 200, 500, 1000, 2000, 5000, 8000, 10000,
+                                   12000, 14000, 16000, 18000, 20000};
+    const double maxFreq = 0.4 * std::min(sc.Rate, static_cast<double>(OUTPUT_SAMPLE_RATE));
+    double minGain = 1e9, maxGain = -1e9;
+
+    std::printf("%-7s %8s %8s %9s %8s\n", "kernel", "rate", "tone_Hz", "gain_dB", "thdn_dB");
+    for (double f : freqs)
+    {
+        if (f > maxFreq) break;
+        sc.ToneHz = f;
+        sResult r = RunScenario(sc, nullptr);
+        std::printf("%-7s %8.0f %8.0f %9.4f %8.1f\n", InterpName(sc.Interp), sc.Rate, f, r.GainDb, r.ThdnDb);
+        minGain = std::min(minGain, r.GainDb);
+        maxGain = std::max(maxGain, r.GainDb);
+    }
+    std::printf("passband ripple up to %.0f Hz: %.4f dB\n", maxFreq, maxGain - minGain);
+}
+
+// -----------------------------------------------------------------------------
+// Kernel switches mid-tone: every pair of kernels, switched in the middle of
+// the analysis window once locked. Fails when an output step exceeds the
+// largest step of the tone by SWITCH_STEP_LIMIT (the kernel delays differ by
+// up to 31 frames, a skip or repeat is a step up to twice the amplitude).
+// -----------------------------------------------------------------------------
+static bool RunSwitch(sScenario sc)
+{
+    constexpr double SWITCH_STEP_LIMIT = 1.5;
+    bool pass = true;
+    sc.Seconds = 4.0;
+    sc.Analysis = 1.0;
+    sc.Switch = sc.Seconds - sc.Analysis / 2;
+
+    std::printf("%-7s %-7s %8s %8s %8s %8s\n", "from", "to", "rate", "ppm", "thdn_dB", "step");
+    for (uint8_t from = 0; from < NB_INTERPOLATIONS; from++)
+    {
+        for (uint8_t to = 0; to < NB_INTERPOLATIONS; to++)
+        {
+            if (from == to) continue;
+            sc.Interp = static_cast<eInterpolation>(from);
+            sc.SwitchInterp = static_cast<eInterpolation>(to);
+            sResult r = RunScenario(sc, nullptr);
+            bool ok = r.Locked && (r.StepRatio <= SWITCH_STEP_LIMIT);
+            std::printf("%-7s %-7s %8.0f %8.1f %8.1f %8.3f  %s\n", InterpName(sc.Interp), InterpName(sc.SwitchInterp),
+                        sc.Rate, sc.Ppm, r.ThdnDb, r.StepRatio, ok ? "OK" : "FAIL");
+            pass = pass && ok;
+        }
+    }
+    return pass;
+}
+
+// -----------------------------------------------------------------------------
+// Thread CPU time (ns), not affected by preemption on a loaded host
+// -----------------------------------------------------------------------------
+static double CpuTimeNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Read cost: PullBlock alone on a ring advanced at the scenario rate (ns per
+// output frame), next to the cost of converting every received frame as it
+// arrives (eager conversion at the input rate)
+// -----------------------------------------------------------------------------
+static void RunCost(const sScenario& sc, const std::vector<eInterpolation>& interps)
+{
+    constexpr uint32_t NB_BLOCKS = 200000;
+    static int32_t ring[CIRCULAR_BUFFER_SAMPLES];
+    static float eager[CIRCULAR_BUFFER_SAMPLES];
+    static cPolyphaseSincBank<eSincTaps::Taps16> sinc16;
+    static cPolyphaseSincBank<eSincTaps::Taps32> sinc32;
+    static cPolyphaseSincBank<eSincTaps::Taps64> sinc64;
+    sinc16.Init();
+    sinc32.Init();
+    sinc64.Init();
+
+    std::mt19937 rng(sc.Seed);
+    for (int32_t& v : ring) v = static_cast<int32_t>(rng() & 0xFFFFFF);
+
+    const double ratio = sc.Rate / OUTPUT_SAMPLE_RATE;
+    const uint64_t increment = static_cast<uint64_t>(ratio * PHASE_ONE);
+    float block[TX_BUFFER_SIZE];
+    volatile float sink = 0.0f;
+
+    std::printf("%-7s %8s %12s %12s\n", "kernel", "rate", "pull_ns", "eager_ns");
+    for (eInterpolation interp : interps)
+    {
+        const cPolyphaseSinc* pSinc = nullptr;
+        if (interp == eInterpolation::Sinc16) pSinc = &sinc16;
+        if (interp == eInterpolation::Sinc32) pSinc = &sinc32;
+        if (interp == eInterpolation::Sinc64) pSinc = &sinc64;
+        cCircularBuff buffer;
+        buffer.setStorage(ring);
+        buffer.setInterpolator(interp, pSinc);
+
+        // Eager reference: every new frame converted once
+        uint64_t written = 0;
+        double t0 = CpuTimeNs();
+        for (uint32_t b = 0; b < NB_BLOCKS; b++)
+        {
+            uint32_t first = static_cast<uint32_t>(written >> PHASE_FRAC_BITS) * 2;
+            written += increment * TX_NB_FRAMES;
+            uint32_t last = static_cast<uint32_t>(written >> PHASE_FRAC_BITS) * 2;
+            for (uint32_t k = first; k != last; k++)
+            {
+                uint32_t i = k & (CIRCULAR_BUFFER_SAMPLES - 1);
+                eager[i] = COEF_NORMALIZE * ((ring[i] << 8) >> 8);
+            }
+            sink = sink + eager[first & (CIRCULAR_BUFFER_SAMPLES - 1)];
+        }
+        double t1 = CpuTimeNs();
+
+        // PullBlock at the fill target behind the write position
+        written = static_cast<uint64_t>(CIRCULAR_BUFFER_SIZE) << PHASE_FRAC_BITS;
+        buffer.setWriteIndex(CIRCULAR_BUFFER_SIZE - 1);
+        buffer.setWriteIndex(0);
+        uint64_t phase = buffer.getPhase(FILL_TARGET);
+        double t2 = CpuTimeNs();
+        for (uint32_t b = 0; b < NB_BLOCKS; b++)
+        {
+            written += increment * TX_NB_FRAMES;
+            buffer.setWriteIndex(static_cast<uint32_t>(written >> PHASE_FRAC_BITS) & CIRCULAR_BUFFER_MASK);
+            buffer.PullBlock(block, phase, increment, TX_NB_FRAMES);
+            sink = sink + block[0];
+        }
+        double t3 = CpuTimeNs();
+
+        double eagerNs = t1 - t0;
+        double pullNs = t3 - t2;
+        double frames = static_cast<double>(NB_BLOCKS) * TX_NB_FRAMES;
+        std::printf("%-7s %8.0f %12.1f %12.1f\n", InterpName(interp), sc.Rate, pullNs / frames, eagerNs / frames);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Uptime check: the 32.32 read phase of an input over days of output frames,
+// across several 2^32 frame wraps of the read and write dates. The read phase
+// only adds its increment (fixed, the drift factor of a locked input, whose
+// quantization the firmware loop corrects), the write date follows the exact
+// source clock. Between the wraps the phase advances block by block; around
+// each read date wrap PullBlock reads a ramp written in the ring and every
+// frame is checked against the exact read position. The phase, write date and
+// age are compared with 128-bit references that never wrap.
+// Returns false on the first difference.
+// -----------------------------------------------------------------------------
+static bool RunUptime(double rate, double ppm, double days)
+{
+    typedef unsigned __int128 u128;
+    constexpr uint64_t LAP_BLOCKS = (CIRCULAR_BUFFER_SIZE / 4 + TX_NB_FRAMES - 1) / TX_NB_FRAMES;  // Write date updates (< a ring lap at ratio 2)
+    constexpr uint64_t CHECK_STEPS = 4096;            // Reference check period out of the wrap windows (laps)
+    constexpr uint32_t WRAP_WINDOW = 65536;           // Output frames read with PullBlock around each wrap
+    constexpr uint32_t RAMP_MASK = 0x1FFFF;           // Ramp period (frames), slope 64 LSB per frame
+    static int32_t ring[CIRCULAR_BUFFER_SAMPLES];
+
+    // Source frames per output frame: srcNum / srcDen, exact to 1e-3 ppm
+    const uint64_t srcNum = static_cast<uint64_t>(std::llround(rate)) * static_cast<uint64_t>(1000000000 + std::llround(ppm * 1000.0));
+    const uint64_t srcDen = 1000000000ull * OUTPUT_SAMPLE_RATE;
+    const uint64_t increment = static_cast<uint64_t>(static_cast<double>(srcNum) / srcDen * PHASE_ONE);
+    const uint64_t blockIncrement = increment * TX_NB_FRAMES;
+    const uint64_t nbBlocks = static_cast<uint64_t>(days * 86400.0 * OUTPUT_SAMPLE_RATE / TX_NB_FRAMES);
+    auto ramp = [](uint64_t date) { return static_cast<int32_t>((date & RAMP_MASK) << 6) - 0x400000; };
+
+    // Boot state of an input: fill target behind the first write date
+    cCircularBuff buffer;
+    buffer.setStorage(ring);
+    buffer.setInterpolator(eInterpolation::Linear, nullptr);
+    buffer.setWriteIndex(CIRCULAR_BUFFER_SIZE / 2);
+    uint64_t phase = buffer.getPhase(FILL_TARGET);
+    const u128 startPhase = phase;
+    const uint64_t startDate = buffer.getDate();
+
+    uint64_t written = startDate;       // Source frames written
+    uint64_t remainder = 0;             // Source clock fraction (srcDen units)
+    uint64_t filled = 0;                // Ring frames holding the ramp
+    uint64_t frames = 0;                // Output frames read
+    uint64_t checks = 0, verified = 0;
+    double ageMin = FILL_TARGET, ageMax = FILL_TARGET;
+    float block[TX_BUFFER_SIZE];
+
+    for (uint64_t b = 0, step = 0; b < nbBlocks; step++)
+    {
+        // One block per step around a read date wrap, else a ring lap
+        bool wrap = (static_cast<uint32_t>(phase >> PHASE_FRAC_BITS) + WRAP_WINDOW / 2) < WRAP_WINDOW;
+        uint64_t count = wrap ? 1 : std::min(LAP_BLOCKS, nbBlocks - b);
+
+        // Write date (exact source clock), set before the reads as by the DMA
+        remainder += srcNum * TX_NB_FRAMES * count;
+        uint64_t received = remainder / srcDen;
+        remainder -= received * srcDen;
+        written += received;
+        buffer.setWriteIndex(static_cast<uint32_t>(written) & CIRCULAR_BUFFER_MASK);
+
+        if (!wrap)
+        {
+            for (uint64_t k = 0; k < count; k++) phase += blockIncrement;
+        }
+        else
+        {
+            // Ramp written up to the write date, then read frame by frame
+            if (filled + CIRCULAR_BUFFER_SIZE < written) filled = written - CIRCULAR_BUFFER_SIZE;
+            for (; filled < written; filled++)
+            {
+                uint32_t i = static_cast<uint32_t>(filled) & CIRCULAR_BUFFER_MASK;
+                ring[i * 2] = ramp(filled) & 0xFFFFFF;
+                ring[i * 2 + 1] = -ramp(filled) & 0xFFFFFF;
+            }
+            buffer.PullBlock(block, phase, increment, TX_NB_FRAMES);
+            for (uint32_t i = 0; i < TX_NB_FRAMES; i++)
+            {
+                u128 position = startPhase + static_cast<u128>(frames + i) * increment;
+                uint64_t date = static_cast<uint64_t>(position >> PHASE_FRAC_BITS);
+                if ((date & RAMP_MASK) == RAMP_MASK) continue;  // Ramp restart
+                double frac = static_cast<uint32_t>(position) / PHASE_ONE;
+                double expected = ramp(date) + 64.0 * frac;
+                if (std::fabs(block[i * 2] * COEF_DENORMALIZE - expected) > 2.0)
+                {
+                    std::printf("uptime: frame %llu read at %.4f instead of %.4f\n", static_cast<unsigned long long>(frames + i),
+                                block[i * 2] * COEF_DENORMALIZE / 64.0, expected / 64.0);
+                    return false;
+                }
+                verified++;
+            }
+        }
+        b += count;
+        frames += TX_NB_FRAMES * count;
+
+        // Step end against the references
+        if (wrap || ((step % CHECK_STEPS) == 0) || (b == nbBlocks))
+        {
+            u128 position = startPhase + static_cast<u128>(frames) * increment;
+            uint64_t date = startDate + static_cast<uint64_t>(static_cast<u128>(frames) * srcNum / srcDen);
+            double age = static_cast<double>(date) - static_cast<double>(position) / PHASE_ONE;
+            if (static_cast<uint64_t>(position) != phase)
+            {
+                std::printf("uptime: read phase differs from the reference after %llu frames\n", static_cast<unsigned long long>(frames));
+                return false;
+            }
+            if ((written != date) || (buffer.getDate() != static_cast<uint32_t>(date)) ||
+                (std::fabs(buffer.getAge(phase) - age) > 1e-3))
+            {
+                std::printf("uptime: write date or age differs from the reference after %llu frames\n",
+                            static_cast<unsigned long long>(frames));
+                return false;
+            }
+            ageMin = std::min(ageMin, age);
+            ageMax = std::max(ageMax, age);
+            checks++;
+        }
+    }
+
+    u128 position = startPhase + static_cast<u128>(frames) * increment;
+    std::printf("uptime %6.0f Hz %+5.0f ppm %5.1f days: %u read / %u write date wraps, %llu checks, "
+                "%llu frames read at the wraps, age %.2f to %.2f frames  OK\n",
+                rate, ppm, days, static_cast<uint32_t>(position >> 64), static_cast<uint32_t>(written >> 32),
+                static_cast<unsigned long long>(checks), static_cast<unsigned long long>(verified), ageMin, ageMax);
+    return true;
+}
+
+static void Usage()
+{
+    std::printf(
+        "HostBench [options]\n"
+        "  --rate HZ        source rate (32000, 44100, 48000, 96000), default: matrix of all\n"
+        "  --ppm P          source clock offset in ppm, default: matrix -200/0/+200\n"
+        "  --jitter US      DMA callback latency (0 to us), default 0\n"
+        "  --seconds S      simulated time, default 6\n"
+        "  --analysis S     analysis window at the end, default 1\n"
+        "  --tone HZ        test tone, default 997\n"
+        "  --level DB       test tone level, default -6\n"
+        "  --interp NAME    linear|cubic|sinc16|sinc32|sinc64|all, default sinc32\n"
+        "  --lock-ppm P     lock tolerance on the ratio, default 50\n"
+        "  --lock-frames F  lock tolerance on the fill level, default 4\n"
+        "  --hint           report the nominal source rate to the mixer (SPDIFRX)\n"
+        "  --deferred       use the firmware queue / Process path\n"
+        "  --glitch S       RX DMA error and restart at S seconds, reports the recovery\n"
+        "  --sweep          passband ripple sweep (needs --rate)\n"
+        "  --switch         kernel switches mid-tone, checks the output continuity\n"
+        "  --cost           PullBlock cost vs. eager conversion (default rate 96000)\n"
+        "  --uptime DAYS    read phase / write date check over DAYS (--rate, --ppm)\n"
+        "  --csv FILE       fill level trajectory (needs --rate)\n"
+        "  --capture FILE   block records of the first run, for CaptureReplay\n"
+        "  --seed N         jitter random seed\n");
+}
+
+// =============================================================================
+// Entry point
+// =============================================================================
+int main(int argc, char** argv)
+{
+    sScenario sc;
+    bool allInterp = false, sweep = false, kernelSwitch = false, cost = false, singleRate = false, singlePpm = false;
+    double uptime = 0.0;
+    const char* pCsvName = nullptr;
+    const char* pCaptureName = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto need = [&]() { if (!val) { Usage(); std::exit(1); } i++; return val; };
+
+        if      (!std::strcmp(arg, "--rate"))        { sc.Rate = std::atof(need()); singleRate = true; }
+        else if (!std::strcmp(arg, "--ppm"))         { sc.Ppm = std::atof(need()); singlePpm = true; }
+        else if (!std::strcmp(arg, "--jitter"))      { sc.JitterUs = std::atof(need()); }
+        else if (!std::strcmp(arg, "--seconds"))     { sc.Seconds = std::atof(need()); }
+        else if (!std::strcmp(arg, "--analysis"))    { sc.Analysis = std::atof(need()); }
+        else if (!std::strcmp(arg, "--tone"))        { sc.ToneHz = std::atof(need()); }
+        else if (!std::strcmp(arg, "--level"))       { sc.LevelDb = std::atof(need()); }
+        else if (!std::strcmp(arg, "--lock-ppm"))    { sc.LockPpm = std::atof(need()); }
+        else if (!std::strcmp(arg, "--lock-frames")) { sc.LockFrames = std::atof(need()); }
+        else if (!std::strcmp(arg, "--hint"))        { sc.Hint = true; }
+        else if (!std::strcmp(arg, "--deferred"))    { sc.Deferred = true; }
+        else if (!std::strcmp(arg, "--glitch"))      { sc.Glitch = std::atof(need()); }
+        else if (!std::strcmp(arg, "--seed"))        { sc.Seed = static_cast<uint32_t>(std::atoi(need())); }
+        else if (!std::strcmp(arg, "--csv"))         { pCsvName = need(); }
+        else if (!std::strcmp(arg, "--capture"))     { pCaptureName = need(); }
+        else if (!std::strcmp(arg, "--sweep"))       { sweep = true; }
+        else if (!std::strcmp(arg, "--switch"))      { kernelSwitch = true; }
+        else if (!std::strcmp(arg, "--cost"))        { cost = true; }
+        else if (!std::strcmp(arg, "--uptime"))      { uptime = std::atof(need()); }
+        else if (!std::strcmp(arg, "--interp"))
+        {
+            const char* name = need();
+            allInterp = !std::strcmp(name, "all");
+            if (!allInterp && !ParseInterp(name, sc.Interp)) { Usage(); return 1; }
+        }
+        else { Usage(); return 1; }
+    }
+
+    if (sc.Analysis >= sc.Seconds) sc.Analysis = sc.Seconds / 2;
+
+    std::vector<eInterpolation> interps;
+    if (allInterp) for (uint8_t k = 0; k < NB_INTERPOLATIONS; k++) interps.push_back(static_cast<eInterpolation>(k));
+    else interps.push_back(sc.Interp);
+
+    std::vector<double> rates = {32000.0, 44100.0, 48000.0, 96000.0};
+    std::vector<double> ppms = {-200.0, 0.0, 200.0};
+    if (singleRate) rates = {sc.Rate};
+    if (singlePpm) ppms = {sc.Ppm};
+
+    if (uptime > 0.0)
+    {
+        return RunUptime(sc.Rate, sc.Ppm, uptime) ? 0 : 1;
+    }
+
+    if (cost)
+    {
+        if (!singleRate) sc.Rate = 96000.0;
+        RunCost(sc, interps);
+        return 0;
+    }
+
+    if (kernelSwitch)
+    {
+        return RunSwitch(sc) ? 0 : 1;
+    }
+
+    if (sweep)
+    {
+        for (eInterpolation interp : interps)
+        {
+            for (double rate : rates)
+            {
+                sc.Interp = interp;
+                sc.Rate = rate;
+                RunSweep(sc);
+            }
+        }
+        return 0;
+    }
+
+    FILE* pCsv = nullptr;
+    if (pCsvName)
+    {
+        pCsv = std::fopen(pCsvName, "w");
+        if (!pCsv) { std::perror(pCsvName); return 1; }
+    }
+    FILE* pCapture = nullptr;
+    if (pCaptureName)
+    {
+        pCapture = std::fopen(pCaptureName, "wb");
+        if (!pCapture) { std::perror(pCaptureName); return 1; }
+    }
+
+    PrintProfile();
+    PrintHeader();
+    for (eInterpolation interp : interps)
+    {
+        for (double rate : rates)
+        {
+            for (double ppm : ppms)
+            {
+                sc.Interp = interp;
+                sc.Rate = rate;
+                sc.Ppm = ppm;
+                PrintResult(sc, RunScenario(sc, pCsv, pCapture));
+                if (pCsv) { std::fclose(pCsv); pCsv = nullptr; }  // Trajectory of the first run only
+                if (pCapture) { std::fclose(pCapture); pCapture = nullptr; }
+            }
+        }
+    }
+    return 0;
+}
+
+//***End of file**************************************************************
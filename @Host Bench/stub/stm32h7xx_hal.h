@@ -0,0 +1,45 @@
+//==================================================================================
+//==================================================================================
+// File: stm32h7xx_hal.h (host stub)
+// Description: Minimal replacement of the HAL / CMSIS headers so the mixer
+//              sources compile natively. Only the symbols used by cMixer are
+//              provided, the DWT cycle counter is backed by plain memory.
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Core clock (defined by the host bench)
+// -----------------------------------------------------------------------------
+extern uint32_t SystemCoreClock;
+
+// -----------------------------------------------------------------------------
+// DWT / CoreDebug registers
+// -----------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+    uint32_t LAR;
+} DWT_Type;
+
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type HostDWT;
+extern CoreDebug_Type HostCoreDebug;
+
+#define DWT (&HostDWT)
+#define CoreDebug (&HostCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+//***End of file**************************************************************
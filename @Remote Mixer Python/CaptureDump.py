@@ -0,0 +1,107 @@
+import mido
+import sys
+import time
+import argparse
+
+# Capture des entrées du mixeur (firmware CAPTURE_ENABLE, cCaptureFlash.h) :
+# le CC 29 à 1 demande le vidage de la zone flash, reçu en messages SysEx et
+# écrit dans un fichier .cap pour @Host Bench/CaptureReplay
+CC_CAPTURE = 29
+SYSEX_ID = 0x7D
+SYSEX_CAPTURE = 0x04
+CAPTURE_VERSION = 1
+
+CAPTURE_STATUS = {0: "arrêtée (CC 29)", 1: "anneau RAM plein (flash trop lente)",
+                  2: "zone flash pleine", 3: "erreur flash",
+                  0xFFFFFFFF: "interrompue (reset ou coupure)"}
+
+def sysex_get32(data, pos):
+    """Décode la valeur 32 bits à la position pos (5 octets de 7 bits, poids faible en premier)"""
+    value = 0
+    for i in range(5):
+        value |= (data[pos + i] & 0x7F) << (7 * i)
+    return value & 0xFFFFFFFF
+
+def unpack_7in8(data, count):
+    """Octets de capture codés 7 dans 8 : un octet des bits de poids fort (bit n pour l'octet n) puis 7 octets"""
+    out = bytearray()
+    pos = 0
+    while len(out) < count:
+        msb = data[pos]
+        group = data[pos + 1:pos + 8]
+        for i, low in enumerate(group):
+            if len(out) == count:
+                break
+            out.append(low | (((msb >> i) & 1) << 7))
+        pos += 8
+    return bytes(out)
+
+def dump(port_in, port_out, channel, path, timeout):
+    chunks = {}
+    length = None
+    status = None
+    port_out.send(mido.Message('control_change', channel=channel, control=CC_CAPTURE, value=1))
+    last = time.monotonic()
+    while length is None:
+        received = False
+        for msg in port_in.iter_pending():
+            if msg.type != 'sysex':
+                continue
+            data = msg.data
+            if len(data) < 13 or data[0] != SYSEX_ID or data[1] != SYSEX_CAPTURE:
+                continue
+            if data[2] != CAPTURE_VERSION:
+                print(f"Version de vidage {data[2]} non supportée")
+                return False
+            received = True
+            offset = sysex_get32(data, 3)
+            count = sysex_get32(data, 8)
+            if count == 0:
+                length = offset
+                status = sysex_get32(data, 13)
+            else:
+                chunks[offset] = unpack_7in8(data[13:], count)
+        now = time.monotonic()
+        if received:
+            last = now
+        elif now - last > timeout:
+            print("Pas de réponse de la carte (CAPTURE_ENABLE, entrée et sortie MIDI)")
+            return False
+        else:
+            time.sleep(0.002)
+
+    # Assemblage, les messages perdus laissent un trou
+    capture = bytearray()
+    for offset in sorted(chunks):
+        if offset != len(capture):
+            break
+        capture += chunks[offset]
+    if len(capture) != length:
+        print(f"Vidage incomplet : {len(capture)} octets sur {length}")
+        return False
+    with open(path, "wb") as f:
+        f.write(capture)
+    print(f"{path} : {length} octets, capture {CAPTURE_STATUS.get(status, status)}")
+    return True
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Vidage de la capture des entrées du mixeur")
+    parser.add_argument("file", help="fichier .cap écrit")
+    parser.add_argument("--port", help="port MIDI (entrée et sortie), défaut : le premier")
+    parser.add_argument("--channel", type=int, default=1, help="canal MIDI 1-16 (défaut 1)")
+    parser.add_argument("--timeout", type=float, default=5.0, help="silence maximal en secondes (arrêt de la capture, effacement flash)")
+    parser.add_argument("--clear", action="store_true", help="efface la zone après le vidage (capture au prochain démarrage)")
+    args = parser.parse_args()
+
+    port_name = args.port
+    if port_name is None:
+        names = mido.get_input_names()
+        if not names:
+            print("Aucun port MIDI, utiliser --port")
+            sys.exit(2)
+        port_name = names[0]
+    with mido.open_input(port_name) as port_in, mido.open_output(port_name) as port_out:
+        ok = dump(port_in, port_out, args.channel - 1, args.file, args.timeout)
+        if ok and args.clear:
+            port_out.send(mido.Message('control_change', channel=args.channel - 1, control=CC_CAPTURE, value=127))
+    sys.exit(0 if ok else 1)
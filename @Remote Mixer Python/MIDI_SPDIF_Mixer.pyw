@@ -2,18 +2,577 @@ import tkinter as tk
 from tkinter import ttk
 import mido
 import math
+import sys
+import time
+import queue
+import random
+import threading
+import collections
+
+# Protocole de télémétrie du firmware (main.h, cTelemetry.h)
+CC_TELEMETRY = 28
+SYSEX_ID = 0x7D
+SYSEX_TELEMETRY = 0x02
+SYSEX_EVENT = 0x03
+TELEMETRY_VERSION = 4
+TELEMETRY_MAX_RATE = 50
+OUTPUT_SAMPLE_RATE = 48000
+CPU_CLOCK = 480000000          # Horloge du STM32H743 (horodatage DWT des événements)
+
+NB_INPUTS = 3                  # Entrées du mixeur, dans l'ordre des sliders (CC 20 à 22)
+INPUT_NAMES = ["SPDIF IN 1", "SPDIF IN 2", "SPDIF IN 3"]
+INPUT_COLORS = ["#4a9eff", "#ff6b4a", "#4aff6b"]
+OUTPUT_COLOR = "#ffaa4a"
+LOCK_STATES = ["NoSync", "Acquire", "Track"]
+EVENT_TYPES = ["Underrun", "Overrun", "Resync"]
+
+GLOBAL_FIELDS = ["seq", "tx_underrun", "tx_request_overflow", "tx_restart", "cpu_load", "cpu_avg",
+                 "cpu_peak", "deadline_miss", "deadline_use", "peak_out", "clips"]
+PERMILLE_FIELDS = ["cpu_load", "cpu_avg", "cpu_peak", "deadline_use"]   # Pour mille, affichés en %
+INPUT_FIELDS = ["lock", "rate", "measured", "drift", "fill", "loop_error",
+                "rx_overflow", "resync", "peak", "underrun", "overrun"]
+EVENT_FIELDS = ["index", "timestamp", "out_date", "fill", "loop_error", "drift", "frames"]
+
+HISTORY_LEN = 600              # Points gardés par courbe
+SIMULATOR_PORT = "SPDIF Mixer Simulator"
+
+# -----------------------------------------------------------------------------
+# Codage des valeurs SysEx : 32 bits sur 5 octets de 7 bits, poids faible
+# en premier, les valeurs signées en complément à deux
+# -----------------------------------------------------------------------------
+def sysex_put32(value):
+    """Code une valeur 32 bits en 5 octets de données SysEx"""
+    value &= 0xFFFFFFFF
+    return [(value >> (7 * i)) & 0x7F for i in range(5)]
+
+def sysex_get32(data, pos):
+    """Décode la valeur 32 bits à la position pos (non signée)"""
+    value = 0
+    for i in range(5):
+        value |= (data[pos + i] & 0x7F) << (7 * i)
+    return value & 0xFFFFFFFF
+
+def to_signed(value):
+    return value - 0x100000000 if value & 0x80000000 else value
+
+def to_fixed(value, shift):
+    """Virgule fixe value * 2^shift saturée sur 32 bits signés (comme le firmware)"""
+    scaled = int(value * (1 << shift))
+    return max(-0x80000000, min(0x7FFFFFFF, scaled))
+
+# Format des champs : (nom, décalage de virgule fixe, signé)
+FIELD_FORMATS = {
+    "cpu_load": (0, False), "peak_out": (24, True),
+    "drift": (28, True), "fill": (8, True), "loop_error": (8, True), "peak": (24, True),
+}
+
+def decode_field(name, raw):
+    shift, signed = FIELD_FORMATS.get(name, (0, False))
+    if signed:
+        raw = to_signed(raw)
+    return raw / float(1 << shift) if shift else raw
+
+def encode_field(name, value):
+    shift, signed = FIELD_FORMATS.get(name, (0, False))
+    return to_fixed(value, shift) if shift else int(value)
+
+def parse_sysex(data):
+    """Décode les données d'un message SysEx (sans F0 / F7).
+    Retourne ("telemetry", trame), ("event", événement) ou None."""
+    data = list(data)
+    if len(data) < 4 or data[0] != SYSEX_ID or data[2] != TELEMETRY_VERSION:
+        return None
+    if data[1] == SYSEX_TELEMETRY:
+        nb_inputs = data[3]
+        if len(data) != 4 + (len(GLOBAL_FIELDS) + len(INPUT_FIELDS) * nb_inputs) * 5:
+            return None
+        pos = 4
+        frame = {}
+        for name in GLOBAL_FIELDS:
+            frame[name] = decode_field(name, sysex_get32(data, pos))
+            pos += 5
+        for name in PERMILLE_FIELDS:
+            frame[name] /= 10.0                        # Pour mille -> %
+        frame["inputs"] = []
+        for _ in range(nb_inputs):
+            values = {}
+            for name in INPUT_FIELDS:
+                values[name] = decode_field(name, sysex_get32(data, pos))
+                pos += 5
+            values["measured"] /= 1000.0               # mHz -> Hz
+            frame["inputs"].append(values)
+        return ("telemetry", frame)
+    if data[1] == SYSEX_EVENT:
+        if len(data) != 6 + len(EVENT_FIELDS) * 5:
+            return None
+        event = {"input": data[3], "type": data[4], "lock": data[5]}
+        pos = 6
+        for name in EVENT_FIELDS:
+            event[name] = decode_field(name, sysex_get32(data, pos))
+            pos += 5
+        return ("event", event)
+    return None
+
+def build_telemetry(frame):
+    """Code une trame de télémétrie comme le firmware (simulateur)"""
+    data = [SYSEX_ID, SYSEX_TELEMETRY, TELEMETRY_VERSION, len(frame["inputs"])]
+    for name in GLOBAL_FIELDS:
+        value = frame[name] * 10.0 if name in PERMILLE_FIELDS else frame[name]
+        data += sysex_put32(encode_field(name, value))
+    for values in frame["inputs"]:
+        for name in INPUT_FIELDS:
+            value = values[name] * 1000.0 if name == "measured" else values[name]
+            data += sysex_put32(encode_field(name, value))
+    return data
+
+def build_event(event):
+    """Code un événement comme le firmware (simulateur)"""
+    data = [SYSEX_ID, SYSEX_EVENT, TELEMETRY_VERSION, event["input"], event["type"], event["lock"]]
+    for name in EVENT_FIELDS:
+        data += sysex_put32(encode_field(name, event[name]))
+    return data
+
+def drift_ppm(values):
+    """Écart du facteur de dérive au rapport nominal (ppm), None sans synchro"""
+    if values["rate"] == 0 or values["drift"] <= 0.0:
+        return None
+    nominal = values["rate"] / float(OUTPUT_SAMPLE_RATE)
+    return (values["drift"] / nominal - 1.0) * 1e6
+
+def level_db(peak):
+    return 20.0 * math.log10(peak) if peak > 1e-6 else -120.0
+
+# -----------------------------------------------------------------------------
+# Lecture de la télémétrie dans un thread : l'interface Tk ne fait que vider
+# la file, elle reste fluide quel que soit le débit des messages
+# -----------------------------------------------------------------------------
+class TelemetryReader(threading.Thread):
+    def __init__(self, port_name, out_queue):
+        super().__init__(daemon=True)
+        self.port_name = port_name
+        self.out_queue = out_queue
+        self.stop_event = threading.Event()
+        self.dropped = 0                 # Messages perdus (file pleine)
+        self.error = None
+
+    def run(self):
+        try:
+            port = mido.open_input(self.port_name)
+        except Exception as e:
+            self.error = e
+            print(f"Erreur d'ouverture de l'entrée MIDI: {e}")
+            return
+        try:
+            while not self.stop_event.is_set():
+                received = False
+                for msg in port.iter_pending():
+                    received = True
+                    if msg.type != 'sysex':
+                        continue
+                    decoded = parse_sysex(msg.data)
+                    if decoded is None:
+                        continue
+                    try:
+                        self.out_queue.put_nowait((time.monotonic(),) + decoded)
+                    except queue.Full:
+                        self.dropped += 1
+                if not received:
+                    time.sleep(0.002)
+        finally:
+            port.close()
+
+    def stop(self):
+        self.stop_event.set()
+
+# -----------------------------------------------------------------------------
+# Simulateur : envoie des trames au format du firmware sur un port MIDI de
+# bouclage (port virtuel créé par le simulateur, ou port existant comme
+# loopMIDI sous Windows), pour tester le tableau de bord sans la carte.
+# Le CC 28 reçu sur son entrée change la cadence, comme sur la carte.
+# -----------------------------------------------------------------------------
+class TelemetrySimulator(threading.Thread):
+    def __init__(self, port_name=None, rate=10):
+        super().__init__(daemon=True)
+        self.port_name = port_name       # None : ports virtuels SIMULATOR_PORT
+        self.rate = rate
+        self.stop_event = threading.Event()
+        self.ready = threading.Event()
+        self.output = None
+        self.input = None
+        self.seq = 0
+        self.events = 0
+        self.out_date = 0
+        self.clips = 0
+        self.tx_underrun = 0
+        self.deadline_miss = 0
+        self.cpu_avg = 35.0
+        self.start_time = time.monotonic()
+        # Entrée 1 : 48 kHz verrouillée, entrée 2 : 44,1 kHz à +150 ppm en
+        # acquisition, entrée 3 : 96 kHz coupée périodiquement
+        self.inputs = [
+            {"rate": 48000, "ppm": -20.0, "lock": 2, "level": 0.5},
+            {"rate": 44100, "ppm": 150.0, "lock": 1, "level": 0.3},
+            {"rate": 96000, "ppm": 60.0, "lock": 0, "level": 0.8},
+        ]
+        for values in self.inputs:
+            values.update(fill=10.0, loop_error=0.0, rx_overflow=0, resync=0, underrun=0, overrun=0)
+
+    def open_ports(self):
+        if self.port_name is None:
+            self.output = mido.open_output(SIMULATOR_PORT, virtual=True)
+            self.input = mido.open_input(SIMULATOR_PORT, virtual=True)
+        else:
+            self.output = mido.open_output(self.port_name)
+
+    def run(self):
+        try:
+            self.open_ports()
+        except Exception as e:
+            print(f"Simulateur: impossible d'ouvrir le port MIDI ({e})")
+            self.ready.set()
+            return
+        self.ready.set()
+        next_frame = time.monotonic()
+        try:
+            while not self.stop_event.is_set():
+                if self.input is not None:
+                    for msg in self.input.iter_pending():
+                        if msg.type == 'control_change' and msg.control == CC_TELEMETRY:
+                            self.rate = min(msg.value, TELEMETRY_MAX_RATE)
+                if self.rate == 0:
+                    time.sleep(0.05)
+                    next_frame = time.monotonic()
+                    continue
+                now = time.monotonic()
+                if now < next_frame:
+                    time.sleep(min(next_frame - now, 0.05))
+                    continue
+                next_frame += 1.0 / self.rate
+                self.send_frame(now)
+        finally:
+            self.output.close()
+            if self.input is not None:
+                self.input.close()
+
+    def send_event(self, ch, event_type, frames=0):
+        values = self.inputs[ch]
+        event = {"input": ch, "type": event_type, "lock": values["lock"], "index": self.events,
+                 "timestamp": int((time.monotonic() - self.start_time) * CPU_CLOCK) & 0xFFFFFFFF,
+                 "out_date": self.out_date & 0xFFFFFFFF, "fill": values["fill"],
+                 "loop_error": values["loop_error"], "drift": self.drift_factor(values), "frames": frames}
+        self.events += 1
+        self.output.send(mido.Message('sysex', data=build_event(event)))
+
+    def drift_factor(self, values):
+        if values["lock"] == 0:
+            return 0.0
+        return values["rate"] / float(OUTPUT_SAMPLE_RATE) * (1.0 + values["ppm"] * 1e-6)
+
+    def send_frame(self, now):
+        t = now - self.start_time
+        self.out_date = int(t * OUTPUT_SAMPLE_RATE)
+        for ch, values in enumerate(self.inputs):
+            # Entrée 3 : 4 s de signal, 2 s de silence
+            if ch == 2:
+                on = (t % 6.0) < 4.0
+                if on and values["lock"] == 0:
+                    values["lock"] = 1
+                    values["resync"] += 1
+                    self.send_event(ch, 2)
+                elif not on:
+                    values["lock"] = 0
+            # Acquisition puis verrouillage
+            if values["lock"] == 1:
+                values["loop_error"] *= 0.9
+                if random.random() < 0.02:
+                    values["lock"] = 2
+            values["fill"] = 10.0 + values["loop_error"] + random.gauss(0.0, 0.3)
+            if values["lock"] != 0 and random.random() < 0.003:
+                values["underrun"] += 1
+                self.send_event(ch, 0, random.randint(1, 5))
+                values["loop_error"] = random.uniform(-3.0, 3.0)
+        cpu = max(0.0, 35.0 + 10.0 * math.sin(t * 0.7) + random.gauss(0.0, 2.0))
+        self.cpu_avg += (cpu - self.cpu_avg) * 0.1
+        deadline = min(150.0, 2.0 * cpu + abs(random.gauss(0.0, 8.0)))
+        if deadline > 100.0:
+            self.deadline_miss += 1
+        peaks = []
+        for ch, values in enumerate(self.inputs):
+            level = values["level"] * (0.6 + 0.4 * abs(math.sin(t * (0.5 + ch * 0.3))))
+            peaks.append(level if values["lock"] != 0 else 0.0)
+        peak_out = min(1.5, sum(peaks) * 0.8)
+        if peak_out > 1.0:
+            self.clips += 1
+        frame = {"seq": self.seq, "tx_underrun": self.tx_underrun, "tx_request_overflow": 0, "tx_restart": 0,
+                 "cpu_load": cpu, "cpu_avg": self.cpu_avg,
+                 "cpu_peak": cpu + abs(random.gauss(0.0, 5.0)), "deadline_miss": self.deadline_miss,
+                 "deadline_use": deadline, "peak_out": peak_out, "clips": self.clips, "inputs": []}
+        for ch, values in enumerate(self.inputs):
+            synced = values["lock"] != 0
+            frame["inputs"].append({
+                "lock": values["lock"], "rate": values["rate"] if synced else 0,
+                "measured": values["rate"] * (1.0 + values["ppm"] * 1e-6) if synced else 0.0,
+                "drift": self.drift_factor(values), "fill": values["fill"],
+                "loop_error": values["loop_error"] if synced else 0.0,
+                "rx_overflow": values["rx_overflow"], "resync": values["resync"], "peak": peaks[ch],
+                "underrun": values["underrun"], "overrun": values["overrun"]})
+        self.seq += 1
+        self.output.send(mido.Message('sysex', data=build_telemetry(frame)))
+
+    def stop(self):
+        self.stop_event.set()
+
+# -----------------------------------------------------------------------------
+# Historique des trames reçues, partagé par les courbes
+# -----------------------------------------------------------------------------
+class TelemetryHistory:
+    def __init__(self):
+        self.times = collections.deque(maxlen=HISTORY_LEN)
+        self.series = collections.defaultdict(lambda: collections.deque(maxlen=HISTORY_LEN))
+        self.last = None                 # Dernière trame
+        self.events = collections.deque(maxlen=200)
+        self.event_total = 0             # Événements reçus
+        self.frames = 0
+        self.lost = 0                    # Trames non envoyées par la carte (USB occupé)
+        self.last_seq = None
+        self.rate_window = collections.deque(maxlen=50)
+
+    def add_frame(self, t, frame):
+        if self.last_seq is not None:
+            gap = (frame["seq"] - self.last_seq - 1) & 0xFFFFFFFF
+            if gap < 0x80000000:
+                self.lost += gap
+        self.last_seq = frame["seq"]
+        self.frames += 1
+        self.last = frame
+        self.rate_window.append(t)
+        self.times.append(t)
+        self.series["cpu"].append(frame["cpu_load"])
+        self.series["cpu_peak"].append(frame["cpu_peak"])
+        self.series["deadline"].append(frame["deadline_use"])
+        self.series["peak_out"].append(level_db(frame["peak_out"]))
+        for ch, values in enumerate(frame["inputs"]):
+            synced = values["lock"] != 0
+            self.series[f"fill{ch}"].append(values["fill"] if synced else None)
+            self.series[f"ppm{ch}"].append(drift_ppm(values))
+            self.series[f"peak{ch}"].append(level_db(values["peak"]) if synced else None)
+
+    def add_event(self, t, event):
+        self.events.append((t, event))
+        self.event_total += 1
+
+    def frame_rate(self):
+        if len(self.rate_window) < 2:
+            return 0.0
+        span = self.rate_window[-1] - self.rate_window[0]
+        return (len(self.rate_window) - 1) / span if span > 0 else 0.0
+
+# -----------------------------------------------------------------------------
+# Courbe déroulante (Canvas), plusieurs séries sur la même échelle
+# -----------------------------------------------------------------------------
+class StripChart(tk.Canvas):
+    def __init__(self, parent, title, series, fixed_range=None, min_span=1.0, width=520, height=120):
+        super().__init__(parent, width=width, height=height, bg='#1e1e1e', highlightthickness=0)
+        self.title = title
+        self.series = series             # [(clé, couleur)]
+        self.fixed_range = fixed_range   # (min, max) ou None pour une échelle automatique
+        self.min_span = min_span
+        self.w = width
+        self.h = height
+
+    def draw(self, history):
+        self.delete('all')
+        left, right, top, bottom = 48, self.w - 6, 16, self.h - 6
+        self.create_text(left, 2, text=self.title, anchor='nw', fill='#bbb', font=('Arial', 8, 'bold'))
+        values = [v for key, _ in self.series for v in history.series[key] if v is not None]
+        if self.fixed_range is not None:
+            lo, hi = self.fixed_range
+        elif values:
+            lo, hi = min(values), max(values)
+            if hi - lo < self.min_span:
+                mid = (hi + lo) / 2.0
+                lo, hi = mid - self.min_span / 2.0, mid + self.min_span / 2.0
+        else:
+            lo, hi = 0.0, self.min_span
+        # Grille et graduations
+        for i in range(3):
+            value = lo + (hi - lo) * i / 2.0
+            y = bottom - (bottom - top) * i / 2.0
+            self.create_line(left, y, right, y, fill='#333')
+            self.create_text(left - 4, y, text=f"{value:.4g}", anchor='e', fill='#888', font=('Arial', 7))
+        # Séries (une polyligne par segment continu)
+        n = HISTORY_LEN
+        for key, color in self.series:
+            data = list(history.series[key])
+            offset = n - len(data)
+            segment = []
+            for i, v in enumerate(data):
+                if v is None:
+                    self.draw_segment(segment, color)
+                    segment = []
+                    continue
+                v = max(lo, min(hi, v))
+                x = left + (right - left) * (offset + i) / (n - 1)
+                y = bottom - (bottom - top) * (v - lo) / (hi - lo)
+                segment += [x, y]
+            self.draw_segment(segment, color)
+
+    def draw_segment(self, segment, color):
+        if len(segment) >= 4:
+            self.create_line(*segment, fill=color, width=1)
+
+# -----------------------------------------------------------------------------
+# Tableau de bord : état des entrées, compteurs, courbes et événements
+# -----------------------------------------------------------------------------
+class TelemetryDashboard:
+    def __init__(self, app):
+        self.app = app
+        self.win = tk.Toplevel(app.root)
+        self.win.title("SPDIF Mixer - Monitoring")
+        self.win.configure(bg='#2b2b2b')
+        self.win.protocol("WM_DELETE_WINDOW", self.close)
+        self.labels = {}
+        self.meters = []
+
+        # État des entrées
+        table = tk.Frame(self.win, bg='#2b2b2b')
+        table.pack(padx=10, pady=5, fill='x')
+        columns = ["Entrée", "État", "Fréq.", "Mesurée (Hz)", "Remplissage", "Dérive (ppm)",
+                   "Underruns", "Overruns", "Resyncs", "Crête"]
+        for col, text in enumerate(columns):
+            tk.Label(table, text=text, bg='#2b2b2b', fg='#888', font=('Arial', 8)).grid(row=0, column=col, padx=4)
+        for ch in range(NB_INPUTS):
+            tk.Label(table, text=INPUT_NAMES[ch], bg='#2b2b2b', fg=INPUT_COLORS[ch],
+                     font=('Arial', 9, 'bold')).grid(row=ch + 1, column=0, padx=4, sticky='w')
+            for col, key in enumerate(["lock", "rate", "measured", "fill", "ppm", "underrun", "overrun", "resync"]):
+                label = tk.Label(table, text="-", bg='#2b2b2b', fg='white', font=('Courier', 9), width=11)
+                label.grid(row=ch + 1, column=col + 1)
+                self.labels[(ch, key)] = label
+            meter = tk.Canvas(table, width=100, height=10, bg='#333', highlightthickness=0)
+            meter.grid(row=ch + 1, column=len(columns) - 1, padx=4)
+            self.meters.append(meter)
+
+        # Compteurs globaux
+        status = tk.Frame(self.win, bg='#2b2b2b')
+        status.pack(padx=10, pady=5, fill='x')
+        for i, (key, text) in enumerate([("cpu", "CPU"), ("cpu_avg", "CPU 1 s"), ("cpu_peak", "CPU crête"),
+                                         ("deadline", "Échéance"), ("deadline_miss", "Échéances manquées"),
+                                         ("peak_out", "Sortie"), ("clips", "Saturations"),
+                                         ("tx_underrun", "TX underruns"), ("tx_request_overflow", "Requêtes TX perdues"),
+                                         ("lost", "Trames perdues"),
+                                         ("fps", "Trames/s")]):
+            row, col = 2 * (i // 5), i % 5
+            tk.Label(status, text=text, bg='#2b2b2b', fg='#888', font=('Arial', 8)).grid(row=row, column=col, padx=6)
+            label = tk.Label(status, text="-", bg='#2b2b2b', fg='white', font=('Courier', 9))
+            label.grid(row=row + 1, column=col, padx=6)
+            self.labels[key] = label
+
+        # Courbes
+        charts = tk.Frame(self.win, bg='#2b2b2b')
+        charts.pack(padx=10, pady=5)
+        inputs = [(f"fill{ch}", INPUT_COLORS[ch]) for ch in range(NB_INPUTS)]
+        self.charts = [
+            StripChart(charts, "Remplissage (trames)", inputs, min_span=4.0),
+            StripChart(charts, "Dérive (ppm)", [(f"ppm{ch}", INPUT_COLORS[ch]) for ch in range(NB_INPUTS)], min_span=20.0),
+            StripChart(charts, "Charge CPU, échéance (%)", [("cpu", OUTPUT_COLOR), ("cpu_peak", "#ff6b4a"),
+                                                              ("deadline", "#888888")], fixed_range=(0.0, 100.0)),
+            StripChart(charts, "Crête (dBFS)", [(f"peak{ch}", INPUT_COLORS[ch]) for ch in range(NB_INPUTS)]
+                       + [("peak_out", OUTPUT_COLOR)], fixed_range=(-60.0, 6.0)),
+        ]
+        for i, chart in enumerate(self.charts):
+            chart.grid(row=i // 2, column=i % 2, padx=3, pady=3)
+
+        # Événements
+        tk.Label(self.win, text="Événements", bg='#2b2b2b', fg='#888', font=('Arial', 8)).pack(anchor='w', padx=10)
+        self.event_list = tk.Listbox(self.win, height=6, bg='#1e1e1e', fg='white', font=('Courier', 8))
+        self.event_list.pack(padx=10, pady=(0, 10), fill='x')
+        self.shown_events = 0
+
+    def update(self, history):
+        frame = history.last
+        if frame is not None:
+            for ch, values in enumerate(frame["inputs"][:NB_INPUTS]):
+                synced = values["lock"] != 0
+                ppm = drift_ppm(values)
+                texts = {
+                    "lock": LOCK_STATES[values["lock"]] if values["lock"] < len(LOCK_STATES) else "?",
+                    "rate": f"{values['rate']}" if synced else "-",
+                    "measured": f"{values['measured']:.2f}" if values["measured"] > 0 else "-",
+                    "fill": f"{values['fill']:.2f}" if synced else "-",
+                    "ppm": f"{ppm:+.1f}" if ppm is not None else "-",
+                    "underrun": str(values["underrun"]), "overrun": str(values["overrun"]),
+                    "resync": str(values["resync"]),
+                }
+                for key, text in texts.items():
+                    self.labels[(ch, key)].config(text=text)
+                self.draw_meter(self.meters[ch], values["peak"], INPUT_COLORS[ch])
+            self.labels["cpu"].config(text=f"{frame['cpu_load']:.1f} %")
+            self.labels["cpu_avg"].config(text=f"{frame['cpu_avg']:.1f} %")
+            self.labels["cpu_peak"].config(text=f"{frame['cpu_peak']:.1f} %")
+            self.labels["deadline"].config(text=f"{frame['deadline_use']:.1f} %",
+                                           fg='#ff4444' if frame["deadline_use"] > 100.0 else 'white')
+            self.labels["deadline_miss"].config(text=str(frame["deadline_miss"]),
+                                                fg='#ff4444' if frame["deadline_miss"] > 0 else 'white')
+            self.labels["peak_out"].config(text=f"{level_db(frame['peak_out']):.1f} dB",
+                                           fg='#ff4444' if frame["peak_out"] > 1.0 else 'white')
+            self.labels["clips"].config(text=str(frame["clips"]))
+            self.labels["tx_underrun"].config(text=str(frame["tx_underrun"]))
+            self.labels["tx_request_overflow"].config(text=str(frame["tx_request_overflow"]),
+                                                      fg='#ff4444' if frame["tx_request_overflow"] > 0 else 'white')
+        self.labels["lost"].config(text=str(history.lost))
+        self.labels["fps"].config(text=f"{history.frame_rate():.1f}")
+        for chart in self.charts:
+            chart.draw(history)
+        self.update_events(history)
+
+    def draw_meter(self, meter, peak, color):
+        meter.delete('all')
+        db = max(-60.0, min(0.0, level_db(peak)))
+        width = int(100 * (db + 60.0) / 60.0)
+        meter.create_rectangle(0, 0, width, 10, fill='#ff4444' if peak > 1.0 else color, width=0)
+
+    def update_events(self, history):
+        count = min(history.event_total - self.shown_events, len(history.events))
+        new = list(history.events)[len(history.events) - count:] if count > 0 else []
+        for t, event in new:
+            name = EVENT_TYPES[event["type"]] if event["type"] < len(EVENT_TYPES) else "?"
+            lock = LOCK_STATES[event["lock"]] if event["lock"] < len(LOCK_STATES) else "?"
+            ch = event["input"]
+            self.event_list.insert('end',
+                f"#{event['index']:<5} {event['out_date'] / OUTPUT_SAMPLE_RATE:10.3f} s  "
+                f"{INPUT_NAMES[ch] if ch < NB_INPUTS else ch:<11} {name:<8} {lock:<7} "
+                f"fill {event['fill']:6.2f}  err {event['loop_error']:+6.2f}  "
+                f"ratio {event['drift']:.6f}  {event['frames']} trames")
+        if new:
+            self.event_list.see('end')
+            while self.event_list.size() > 200:
+                self.event_list.delete(0)
+        self.shown_events = history.event_total
+
+    def close(self):
+        self.app.dashboard = None
+        self.win.destroy()
 
 class SPDIFMixer:
-    def __init__(self, root):
+    def __init__(self, root, simulator=None):
         self.root = root
         self.root.title("SPDIF Mixer")
-        self.root.geometry("450x550")
+        self.root.geometry("450x640")
         self.root.configure(bg="#494949")
         
         # Variables MIDI
         self.midi_output = None
         self.midi_channel = 0
         
+        # Télémétrie : lecture dans un thread, historique et tableau de bord
+        self.simulator = simulator
+        self.reader = None
+        self.telemetry_queue = queue.Queue(maxsize=2000)
+        self.history = TelemetryHistory()
+        self.dashboard = None
+        self.last_draw = 0.0
+        self.redraw = False
+        
         # Configuration des sliders
         self.slider_config = [
             {"name": "SPDIF IN 1", "cc": 20, "color": "#4a9eff"},
@@ -28,6 +587,7 @@ class SPDIFMixer:
         
         self.setup_ui()
         self.refresh_midi_ports()
+        self.root.after(50, self.poll_telemetry)
         
     def db_to_midi(self, db):
         """Convertit dB (-45 à +6) en valeur MIDI (0-127)"""
@@ -69,6 +629,24 @@ class SPDIFMixer:
         channel_combo.grid(row=1, column=1, padx=5, sticky='w')
         channel_combo.bind('<<ComboboxSelected>>', self.on_channel_change)
         
+        # Sélection entrée MIDI (télémétrie)
+        tk.Label(config_frame, text="Entrée MIDI:", bg='#666666', fg='white').grid(row=2, column=0, padx=5, sticky='w')
+        self.midi_in_var = tk.StringVar()
+        self.midi_in_combo = ttk.Combobox(config_frame, textvariable=self.midi_in_var, width=30, state='readonly')
+        self.midi_in_combo.grid(row=2, column=1, padx=5)
+        self.midi_in_combo.bind('<<ComboboxSelected>>', self.on_midi_in_change)
+        
+        # Cadence de télémétrie (CC 28) et tableau de bord
+        tk.Label(config_frame, text="Télémétrie (/s):", bg='#666666', fg='white').grid(row=3, column=0, padx=5, pady=5, sticky='w')
+        telemetry_frame = tk.Frame(config_frame, bg='#666666')
+        telemetry_frame.grid(row=3, column=1, sticky='w', padx=5)
+        self.telemetry_rate_var = tk.IntVar(value=10)
+        rate_spinbox = tk.Spinbox(telemetry_frame, from_=0, to=TELEMETRY_MAX_RATE, textvariable=self.telemetry_rate_var,
+                                  width=5, command=self.on_telemetry_rate_change)
+        rate_spinbox.pack(side='left')
+        rate_spinbox.bind('<Return>', lambda e: self.on_telemetry_rate_change())
+        tk.Button(telemetry_frame, text="Moniteur", command=self.open_dashboard, bg='#444', fg='white').pack(side='left', padx=10)
+        
         # Frame pour les sliders
         sliders_frame = tk.Frame(self.root, bg='#2b2b2b')
         sliders_frame.pack(pady=20, expand=True, fill='both')
@@ -170,8 +748,12 @@ class SPDIFMixer:
     def send_midi(self, index, db_value):
         """Envoie le message MIDI CC"""
         cc_num = self.slider_config[index]["cc"]
-        if cc_num is not None and self.midi_output is not None:
-            midi_value = self.db_to_midi(db_value)
+        if cc_num is not None:
+            self.send_cc(cc_num, self.db_to_midi(db_value))
+    
+    def send_cc(self, cc_num, midi_value):
+        """Envoie un Control Change sur le port de sortie"""
+        if self.midi_output is not None:
             try:
                 msg = mido.Message('control_change', 
                                  channel=self.midi_channel, 
@@ -186,8 +768,23 @@ class SPDIFMixer:
         ports = mido.get_output_names()
         self.midi_port_combo['values'] = ports
         if ports:
-            self.midi_port_combo.current(0)
+            self.midi_port_combo.current(self.default_port(ports))
             self.on_midi_port_change(None)
+        
+        in_ports = mido.get_input_names()
+        self.midi_in_combo['values'] = in_ports
+        if in_ports:
+            self.midi_in_combo.current(self.default_port(in_ports))
+            self.on_midi_in_change(None)
+    
+    def default_port(self, ports):
+        """Port du simulateur s'il tourne, sinon le premier"""
+        if self.simulator is not None:
+            name = self.simulator.port_name or SIMULATOR_PORT
+            for i, port in enumerate(ports):
+                if port.startswith(name):
+                    return i
+        return 0
     
     def on_midi_port_change(self, event):
         """Change le port MIDI sélectionné"""
@@ -203,12 +800,71 @@ class SPDIFMixer:
                 print(f"Erreur de connexion MIDI: {e}")
                 self.midi_output = None
     
+    def on_midi_in_change(self, event):
+        """Relance la lecture de la télémétrie sur l'entrée sélectionnée"""
+        if self.reader is not None:
+            self.reader.stop()
+            self.reader.join(timeout=1.0)
+            self.reader = None
+        while not self.telemetry_queue.empty():
+            self.telemetry_queue.get_nowait()
+        self.history = TelemetryHistory()
+        
+        port_name = self.midi_in_var.get()
+        if port_name:
+            self.reader = TelemetryReader(port_name, self.telemetry_queue)
+            self.reader.start()
+            print(f"Télémétrie sur: {port_name}")
+    
+    def on_telemetry_rate_change(self):
+        """Envoie la cadence de télémétrie (0 = arrêt)"""
+        try:
+            rate = max(0, min(TELEMETRY_MAX_RATE, int(self.telemetry_rate_var.get())))
+        except (ValueError, tk.TclError):
+            return
+        self.send_cc(CC_TELEMETRY, rate)
+    
+    def open_dashboard(self):
+        if self.dashboard is None:
+            self.dashboard = TelemetryDashboard(self)
+            self.dashboard.update(self.history)
+        else:
+            self.dashboard.win.lift()
+    
+    def poll_telemetry(self):
+        """Vide la file du thread de lecture (thread Tk), redessine à 10 Hz au plus"""
+        for _ in range(self.telemetry_queue.maxsize):
+            try:
+                t, kind, data = self.telemetry_queue.get_nowait()
+            except queue.Empty:
+                break
+            self.redraw = True
+            if kind == "telemetry":
+                self.history.add_frame(t, data)
+            else:
+                self.history.add_event(t, data)
+        now = time.monotonic()
+        if self.dashboard is not None and self.redraw and now - self.last_draw >= 0.1:
+            self.last_draw = now
+            self.redraw = False
+            self.dashboard.update(self.history)
+        self.root.after(50, self.poll_telemetry)
+    
     def on_channel_change(self, event):
         """Change le canal MIDI (0-15 en interne, affiché 1-16)"""
         self.midi_channel = self.channel_var.get() - 1
         print(f"Canal MIDI: {self.channel_var.get()}")
 
 if __name__ == "__main__":
+    # --simulate : trames simulées sur un port virtuel (Linux, macOS)
+    # --simulate PORT : trames simulées sur un port de bouclage existant (loopMIDI)
+    simulator = None
+    if "--simulate" in sys.argv:
+        i = sys.argv.index("--simulate")
+        port_name = sys.argv[i + 1] if i + 1 < len(sys.argv) else None
+        simulator = TelemetrySimulator(port_name)
+        simulator.start()
+        simulator.ready.wait(2.0)
     root = tk.Tk()
-    app = SPDIFMixer(root)
+    app = SPDIFMixer(root, simulator)
     root.mainloop()
\ No newline at end of file
@@ -0,0 +1,40 @@
+//==================================================================================
+//==================================================================================
+// File: AudioTask.h
+// Description: Deferred audio processing on the PendSV exception (lowest
+//              priority software interrupt)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+
+// =============================================================================
+// Configuration constants
+// =============================================================================
+
+#define AUDIO_TASK_PRIORITY 15        // NVIC preemption priority (lowest, 4 bits)
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Sets the PendSV priority below all peripheral interrupts
+// -----------------------------------------------------------------------------
+inline void AudioTaskInit()
+{
+    NVIC_SetPriority(PendSV_IRQn, AUDIO_TASK_PRIORITY);
+}
+
+// -----------------------------------------------------------------------------
+// Requests a run of the audio task (from any interrupt)
+// -----------------------------------------------------------------------------
+inline void AudioTaskTrigger()
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
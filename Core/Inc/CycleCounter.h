@@ -0,0 +1,39 @@
+//==================================================================================
+//==================================================================================
+// File: CycleCounter.h
+// Description: CPU cycle counter (Cortex-M7 DWT CYCCNT) access helpers
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Enables the DWT cycle counter (idempotent)
+// -----------------------------------------------------------------------------
+inline void CycleCounterInit()
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;  // Enable trace and debug blocks
+        DWT->LAR = 0xC5ACCE55;                           // Unlock DWT registers
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Gets current cycle count (wraps every 2^32 cycles, ~8.9s at 480MHz)
+// -----------------------------------------------------------------------------
+inline uint32_t CycleCounterGet()
+{
+    return DWT->CYCCNT;
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
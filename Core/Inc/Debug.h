@@ -1,17 +1,100 @@
-
-#include "stdint.h"
+//==================================================================================
+//==================================================================================
+// File: Debug.h
+// Description: Cycle profiling probes (DWT cycle counter), debug builds only
+//
+// PROFILE_START(Start) ... PROFILE_STOP(Start, Probe) records the cycles spent
+// between the two macros into the probe: count, min, max, mean and a log2
+// histogram (bin n counts the durations of 2^n to 2^(n+1) - 1 cycles). A
+// probe is written from a single interrupt context; the recording costs a
+// few instructions and two CYCCNT reads.
+//
+// Without DEBUG (Release configuration) the macros are empty and the probes,
+// the USB dump and their storage are not compiled.
+//
+// Readout over USB MIDI: CC_PROFILE (value 0-126) requests a dump, value 127
+// clears the probes. The main loop answers with one SysEx per probe:
+//   F0 SYSEX_ID SYSEX_PROFILE <probe> <bins> <count> <min> <max> <mean>
+//   <bin 0> ... <bin n-1> F7
+// each value in 5 bytes of 7 bits, least significant first.
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
 #pragma once
-struct sDebug{
-	int32_t CtErrPlus;
 
-	int32_t ctDate;
-	int32_t ctDateMax;
-	int32_t ctDateMin;
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef DEBUG
+
+// -----------------------------------------------------------------------------
+// Probes
+// -----------------------------------------------------------------------------
+typedef enum
+{
+    PROBE_TX_DMA = 0,      // SAI1 TX half / complete callback (block hand-off)
+    PROBE_RX_DMA,          // RX half / complete callbacks, one probe per mixer
+                           // input (PROBE_RX_DMA + INPUT_xxx)
+    PROBE_AUDIO_TASK = PROBE_RX_DMA + MIXER_NB_INPUTS,  // Audio task run (PendSV)
+    PROBE_MIX_BLOCK,       // Mix of one TX block (pullSamples / mixBlock)
+    PROBE_CONVERT,         // Conversion of the new input frames of a block
+    PROBE_USB,             // USB OTG FS interrupt
+    NB_PROBES
+} eProbe;
+
+#define PROFILE_NB_BINS 24     // Up to 2^24 cycles (35 ms at 480 MHz), last bin open
+
+typedef struct
+{
+    uint32_t Count;                    // Number of records
+    uint32_t Min;                      // Cycles
+    uint32_t Max;
+    uint64_t Sum;
+    uint32_t Histogram[PROFILE_NB_BINS];
+} sProfileProbe;
+
+extern sProfileProbe ProfileProbes[NB_PROBES];
+
+// -----------------------------------------------------------------------------
+// Records one duration (Count last: the reader detects an update by it)
+// -----------------------------------------------------------------------------
+static inline void Profile_Record(uint32_t Probe, uint32_t Cycles)
+{
+    sProfileProbe* pProbe = &ProfileProbes[Probe];
+    uint32_t Bin = (Cycles == 0) ? 0 : 31 - __builtin_clz(Cycles);
+    if (Bin >= PROFILE_NB_BINS) Bin = PROFILE_NB_BINS - 1;
+
+    if ((pProbe->Count == 0) || (Cycles < pProbe->Min)) pProbe->Min = Cycles;
+    if (Cycles > pProbe->Max) pProbe->Max = Cycles;
+    pProbe->Sum += Cycles;
+    pProbe->Histogram[Bin]++;
+    pProbe->Count++;
+}
+
+// -----------------------------------------------------------------------------
+// Control: reset at start-up, request from the USB interrupt, dump / clear
+// from the main loop
+// -----------------------------------------------------------------------------
+void Profile_Reset(void);
+void Profile_Request(uint8_t Value);
+void Profile_Poll(void);
+
+#define PROFILE_START(Start)         uint32_t Start = DWT->CYCCNT
+#define PROFILE_STOP(Start, Probe)   Profile_Record((Probe), DWT->CYCCNT - (Start))
+
+#else
+
+#define PROFILE_START(Start)
+#define PROFILE_STOP(Start, Probe)
+
+#endif
 
-	int32_t DeltaIn1;
-	int32_t DeltaIn1Min;
-	int32_t DeltaIn1Max;
+#ifdef __cplusplus
+}
+#endif
 
-};
-#define MinMax(Cible, Min, Max) Min = Cible < Min ? Cible : Min; Max = Cible > Max ? Cible : Max
-extern sDebug __Debug;
+//***End of file**************************************************************
@@ -9,6 +9,45 @@
 #define INC_OPTIONS_H_
 #define USB_MIDI
 
+// Audio latency / CPU profile (block sizes, see cMixer.h)
+#define AUDIO_PROFILE_ULTRA_LOW_LATENCY 0   // TX 5 frames blocks, 256 frames rings
+#define AUDIO_PROFILE_BALANCED          1   // TX 16 frames blocks, 512 frames rings
+#define AUDIO_PROFILE_LOW_CPU           2   // TX 64 frames blocks, 2048 frames rings
+
+#ifndef AUDIO_PROFILE
+#define AUDIO_PROFILE AUDIO_PROFILE_ULTRA_LOW_LATENCY
+#endif
+
+// Cortex-M7 I / D caches (0: uncached reference for cycle counts). DMA
+// buffers are in the non-cacheable D2 SRAM region either way (MPU_Config).
+#ifndef CPU_CACHE_ENABLE
+#define CPU_CACHE_ENABLE 1
+#endif
+
+// USB MIDI telemetry frames per second at start-up (0 = off), CC_TELEMETRY
+// changes it at run time
+#ifndef TELEMETRY_RATE
+#define TELEMETRY_RATE 10
+#endif
+#define TELEMETRY_MAX_RATE 50
+
+// Mixer input capture to the QSPI flash for host replay (cCapture.h,
+// @Host Bench/CaptureReplay). The capture starts at boot when the area is
+// empty, CC_CAPTURE stops, dumps or clears it. The sample mask selects the
+// inputs whose received frames are recorded. Timing only (mask 0) takes
+// about 220 / 70 / 18 KB/s with the ULTRA_LOW_LATENCY / BALANCED / LOW_CPU
+// profiles; each recorded input adds 6 bytes per frame (290 KB/s at 48 kHz),
+// which the flash page programs only sustain with the larger blocks.
+#ifndef CAPTURE_ENABLE
+#define CAPTURE_ENABLE 0
+#endif
+#ifndef CAPTURE_SAMPLE_MASK
+#define CAPTURE_SAMPLE_MASK 0x00
+#endif
+#define CAPTURE_RAM_SIZE (256 * 1024)         // Record ring, absorbs the 64 KB erases
+#define CAPTURE_FLASH_OFFSET 0x100000         // Area after the settings sectors
+#define CAPTURE_FLASH_SIZE 0xF00000
+
 
 
 
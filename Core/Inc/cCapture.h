@@ -0,0 +1,195 @@
+//==================================================================================
+//==================================================================================
+// File: cCapture.h
+// Description: Record ring of the mixer inputs for deterministic host replay
+//
+// The mixer writes one record per mixed block with everything the block
+// consumed from the interrupt side: TX callback timestamp, DMA positions,
+// RX half timestamps, receiver restarts, reported source rates and user
+// parameters, the received frames of the inputs in the sample mask, then a
+// hash of its output and of its drift state. Replaying the records through
+// the same cMixer code (@Host Bench/CaptureReplay) rebuilds every block and
+// checks both hashes.
+//
+// Stream (values little endian):
+//   header  'D' 'C' 'A' 'P' <version> <inputs> <AUDIO_PROFILE> <sample mask>
+//           <TX_NB_FRAMES u16> <CIRCULAR_BUFFER_SIZE u16>
+//           <OUTPUT_SAMPLE_RATE u32> <SystemCoreClock u32>
+//   block   CAPTURE_BLOCK <flags> <timestamp u32> <write index u16> x inputs
+//           [CAPTURE_PARAMS: <gain f32> x inputs <master gain f32>
+//                            <interpolation u8> x inputs]
+//           per input: <input flags>
+//             [CAPTURE_RESYNC: <restart timestamp u32>]
+//             [CAPTURE_SOURCE_RATE: <source rate u32>]
+//             [CAPTURE_FRAMES: <first ring frame u16> <count u16>
+//                              <left, right 24-bit> x count]
+//             <ring frame u16> <timestamp u32> x marks (input flags >> 4)
+//           <output hash u32> <state hash u32>
+//
+//   write index   Ring frame written next, CAPTURE_MUTED for no valid audio
+//   frames        Ring frames written since the previous block (inputs of
+//                 the sample mask only), wrapping at the ring end
+//   hashes        FNV-1a of the output block and of the read phase, drift
+//                 factor and lock state of every input
+//
+// Single writer (audio task, or the control side before the DMAs start),
+// single reader (main loop). A record is published whole; when the ring
+// has no room for it the capture stops on the previous record.
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Stream format
+// -----------------------------------------------------------------------------
+constexpr uint8_t CAPTURE_VERSION = 1;
+constexpr uint8_t CAPTURE_HEADER_SIZE = 20;
+constexpr uint8_t CAPTURE_BLOCK = 0xB1;          // Block record tag
+
+constexpr uint8_t CAPTURE_PARAMS = 0x01;         // Block flags: parameter set applied
+constexpr uint8_t CAPTURE_TX_RESTART = 0x02;     //              TX DMA restart applied
+
+constexpr uint8_t CAPTURE_RESYNC = 0x01;         // Input flags: receiver restart applied
+constexpr uint8_t CAPTURE_SOURCE_RATE = 0x02;    //              reported rate changed
+constexpr uint8_t CAPTURE_FRAMES = 0x04;         //              received frames follow
+constexpr uint8_t CAPTURE_MARK_SHIFT = 4;        //              RX half timestamps consumed
+
+constexpr uint16_t CAPTURE_MUTED = 0xFFFF;       // Write index of a muted input
+
+//**********************************************************************************
+// cCapture
+// Byte ring between the mixer (records) and the capture sink (flash, file).
+// The writer fills a record past the published end and publishes it with
+// EndRecord, so the reader never sees a partial record.
+//**********************************************************************************
+class cCapture
+{
+public:
+    enum class eState : uint8_t
+    {
+        Idle,       // Not started
+        Recording,  // Records written at each block
+        Stopped,    // Stop requested, last record published
+        Overflow    // Ring full: stopped before the record that did not fit
+    };
+
+    static constexpr uint32_t HASH_INIT = 2166136261u;  // FNV-1a offset basis
+
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cCapture() : m_pRing(nullptr), m_Mask(0), m_SampleMask(0), m_Write(0), m_Free(0),
+                 m_State(eState::Idle), m_StopRequest(false), m_Head(0), m_Tail(0) {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Sets the ring storage (size a power of two) and the inputs whose
+    // received frames are recorded (bit n = input n)
+    // -------------------------------------------------------------------------
+    void Init(uint8_t* pRing, uint32_t size, uint8_t sampleMask);
+
+    // -------------------------------------------------------------------------
+    // Control side: starts recording (before the writer runs) / requests the
+    // writer to stop at its next record
+    // -------------------------------------------------------------------------
+    void Start();
+    void Stop() { m_StopRequest.store(true, std::memory_order_release); }
+
+    eState getState() const { return m_State.load(std::memory_order_acquire); }
+    bool isRecording() const { return getState() == eState::Recording; }
+    uint8_t getSampleMask() const { return m_SampleMask; }
+
+    // -------------------------------------------------------------------------
+    // Writer: opens a record (false when not recording, the stop request is
+    // applied here), appends values, publishes it
+    // -------------------------------------------------------------------------
+    bool BeginRecord();
+    void EndRecord();
+
+    inline void Put8(uint8_t value)
+    {
+        if (m_Free == 0)
+        {
+            m_Free = OVERFLOW;
+            return;
+        }
+        if (m_Free == OVERFLOW) return;
+        m_pRing[m_Write++ & m_Mask] = value;
+        m_Free--;
+    }
+    inline void Put16(uint16_t value)
+    {
+        Put8(static_cast<uint8_t>(value));
+        Put8(static_cast<uint8_t>(value >> 8));
+    }
+    inline void Put32(uint32_t value)
+    {
+        Put16(static_cast<uint16_t>(value));
+        Put16(static_cast<uint16_t>(value >> 16));
+    }
+    inline void PutFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Put32(bits);
+    }
+
+    // -------------------------------------------------------------------------
+    // Writer: appends samples as their low 24 bits (the ring contents)
+    // -------------------------------------------------------------------------
+    void PutSamples24(const int32_t* pSamples, uint32_t nbSamples);
+
+    // -------------------------------------------------------------------------
+    // Writer: position of the next byte of the record and rewrite of a byte
+    // already appended (input flags known once the values are written)
+    // -------------------------------------------------------------------------
+    inline uint32_t Tell() const { return m_Write; }
+    inline void Patch8(uint32_t position, uint8_t value)
+    {
+        if (m_Free != OVERFLOW) m_pRing[position & m_Mask] = value;
+    }
+
+    // -------------------------------------------------------------------------
+    // Reader: bytes published and not read yet, copies and releases up to
+    // size of them (returns the count)
+    // -------------------------------------------------------------------------
+    uint32_t getAvailable() const { return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_relaxed); }
+    uint32_t Read(uint8_t* pDst, uint32_t size);
+
+    // -------------------------------------------------------------------------
+    // FNV-1a hash of size bytes, continued from hash
+    // -------------------------------------------------------------------------
+    static uint32_t Hash(uint32_t hash, const void* pData, uint32_t size);
+
+private:
+    static constexpr uint32_t OVERFLOW = 0xFFFFFFFF;   // m_Free once the record did not fit
+
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    uint8_t* m_pRing;                   // Record bytes, index & m_Mask
+    uint32_t m_Mask;
+    uint8_t m_SampleMask;               // Inputs whose frames are recorded
+    uint32_t m_Write;                   // Writer: next byte of the open record
+    uint32_t m_Free;                    // Writer: room left for the open record
+    std::atomic<eState> m_State;
+    std::atomic<bool> m_StopRequest;
+    std::atomic<uint32_t> m_Head;       // Published end (writer)
+    std::atomic<uint32_t> m_Tail;       // Read position (reader)
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -0,0 +1,134 @@
+//==================================================================================
+//==================================================================================
+// File: cCaptureFlash.h
+// Description: Capture records (cCapture) to the QSPI flash and USB MIDI dump
+//              (main loop, CAPTURE_ENABLE builds)
+//
+// Flash area (CAPTURE_FLASH_OFFSET, CAPTURE_FLASH_SIZE):
+//   +0     descriptor: <magic u32> <length u32> <status u32>, length and status
+//          programmed when the capture ends (erased = capture interrupted)
+//   +4096  record stream (cCapture.h), as written by the mixer
+// A capture only starts at boot on an empty area: the previous capture is
+// kept until it is cleared, so a power cycle does not lose it. The area is
+// erased block by block ahead of the writes while the RAM ring absorbs the
+// records (an erase takes about 150 ms at 64 KB).
+//
+// Control: CC_CAPTURE value 0 stops the capture, 1 dumps it (stopping it
+// first), 127 clears the area (next boot captures). Dump messages, the data
+// packed 7 bytes in 8 (first byte: most significant bits, bit n for byte n):
+//   F0 SYSEX_ID SYSEX_CAPTURE <version> <offset> <count> <packed data> F7
+// then the end of the dump, count 0:
+//   F0 SYSEX_ID SYSEX_CAPTURE <version> <length> <0> <status> F7
+// offset, count, length and status in 5 bytes of 7 bits, least significant
+// first.
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+#include "cCapture.h"
+#include "W25Q128.h"
+
+namespace Dad {
+
+//**********************************************************************************
+// cCaptureFlash
+// Single context (main loop); Request is the only method called from the USB
+// interrupt.
+//**********************************************************************************
+class cCaptureFlash
+{
+public:
+    static constexpr uint8_t VERSION = 1;
+
+    // -------------------------------------------------------------------------
+    // Capture end reported in the descriptor and the dump
+    // -------------------------------------------------------------------------
+    enum eStatus : uint32_t
+    {
+        STATUS_STOPPED     = 0,            // Stopped by CC_CAPTURE
+        STATUS_OVERFLOW    = 1,            // RAM ring full (flash too slow)
+        STATUS_AREA_FULL   = 2,            // Flash area full, last record truncated
+        STATUS_FLASH_ERROR = 3,            // Erase or write failed, last record truncated
+        STATUS_INTERRUPTED = 0xFFFFFFFF    // Reset or power loss, length from the data
+    };
+
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cCaptureFlash() : m_pFlash(nullptr), m_pCapture(nullptr), m_Base(0), m_DataSize(0), m_Write(0), m_Erased(0),
+                      m_Length(0), m_Status(STATUS_INTERRUPTED), m_Finalized(true),
+                      m_StopRequest(false), m_DumpRequest(false), m_ClearRequest(false),
+                      m_DumpOffset(0), m_MessageSize(0) {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Opens the area (mapped address, size a multiple of 64 KB). Returns true
+    // when it is empty: its first block is then erased and a capture may
+    // start (cCapture::Start, cMixer::attachCapture). Returns false when it
+    // holds a previous capture, kept for the dump, or on a flash error.
+    // -------------------------------------------------------------------------
+    bool Init(DadDrivers::cW25Q128* pFlash, cCapture* pCapture, uint32_t baseAddr, uint32_t size);
+
+    // -------------------------------------------------------------------------
+    // CC_CAPTURE (USB interrupt): 0 stop, 1 dump, 127 clear
+    // -------------------------------------------------------------------------
+    void Request(uint8_t value);
+
+    // -------------------------------------------------------------------------
+    // Main loop: applies the requests, writes the published records, sends
+    // the next dump message
+    // -------------------------------------------------------------------------
+    void Poll();
+
+    // -------------------------------------------------------------------------
+    // Bytes of records in the area / capture end (once finalized)
+    // -------------------------------------------------------------------------
+    uint32_t getLength() const { return m_Finalized ? m_Length : m_Write; }
+    uint32_t getStatus() const { return m_Status; }
+
+private:
+    static constexpr uint32_t MAGIC = 0x50414344;         // "DCAP"
+    static constexpr uint32_t DATA_OFFSET = W25Q128_SECTOR_SIZE;
+    static constexpr uint32_t PAGES_PER_POLL = 16;        // Writes per main loop pass
+    static constexpr uint32_t DUMP_CHUNK = 224;           // Record bytes per dump message (32 groups of 7)
+    static constexpr uint32_t MESSAGE_SIZE = 4 + 3 * 5 + DUMP_CHUNK / 7 * 8 + 1;
+
+    // =========================================================================
+    // Private methods
+    // -------------------------------------------------------------------------
+    void Drain();
+    void Finalize(uint32_t status);
+    void Clear();
+    void SendDump();
+    uint32_t FindEnd();
+
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    DadDrivers::cW25Q128* m_pFlash;
+    cCapture* m_pCapture;
+    uint32_t m_Base;                    // Area mapped address
+    uint32_t m_DataSize;                // Room for records
+    uint32_t m_Write;                   // Record bytes written
+    uint32_t m_Erased;                  // Area bytes erased (from m_Base)
+    uint32_t m_Length;                  // Record bytes of the finalized capture
+    uint32_t m_Status;                  // eStatus of the finalized capture
+    bool m_Finalized;                   // No capture in progress
+    volatile bool m_StopRequest;        // Requests from the USB interrupt
+    volatile bool m_DumpRequest;
+    volatile bool m_ClearRequest;
+    uint32_t m_DumpOffset;              // Next record byte to send
+    uint16_t m_MessageSize;             // Dump message waiting for the USB (0 = none)
+    uint8_t m_Page[W25Q128_PAGE_SIZE];
+    uint8_t m_Message[MESSAGE_SIZE];
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
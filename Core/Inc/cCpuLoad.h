@@ -0,0 +1,164 @@
+//==================================================================================
+//==================================================================================
+// File: cCpuLoad.h
+// Description: CPU load of the audio interrupts and TX deadline meter (DWT
+//              busy cycles against wall-clock cycles)
+//
+// Busy cycles are added by the audio interrupts themselves: the DMA callbacks
+// (TX hand-off, RX ring halves) from their entry timestamp to the end of their
+// mixer call, the audio task over its whole run less the DMA callbacks that
+// preempted it. Other interrupts preempting the audio task (USB, QSPI, TIM6)
+// are counted as audio load.
+//
+// The main loop closes a window every CPU_LOAD_WINDOW_MS and derives:
+//   load          busy cycles of the latest window, per mille
+//   average       busy cycles of the windows of the latest second, per mille
+//   peak          highest window load since the last resetPeaks
+//
+// Deadline: the block requested by the TX callback at time T must be mixed
+// before the next TX callback, T + one TX period. With pullSamples the next
+// DMA half then plays stale data; with the audio task each miss uses up one
+// of the blocks queued ahead, and the TX callback sends silence once they run
+// out (cMixer::getTxUnderrunCount). Each block finished later counts as a
+// deadline miss, and the latest finish is kept as a fraction of the TX period
+// (headroom = 1000 - deadline use).
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+#include "CycleCounter.h"
+#include <atomic>
+
+// =============================================================================
+// Configuration constants
+// =============================================================================
+
+#define CPU_LOAD_WINDOW_MS 10         // Current load window (the average spans 1 s of windows)
+
+namespace Dad {
+
+//**********************************************************************************
+// cCpuLoad
+// Each counter has a single writer: the DMA callbacks (one priority level, they
+// do not preempt each other), the audio task, or the main loop. The main loop
+// reads the busy counters as single words, wrapping like the cycle counter.
+//**********************************************************************************
+class cCpuLoad
+{
+public:
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cCpuLoad() { Init(0, 0); }
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Sets the core clock and the TX period (CPU cycles), clears the counters
+    // -------------------------------------------------------------------------
+    void Init(uint32_t coreClock, uint32_t txPeriod);
+
+    // -------------------------------------------------------------------------
+    // DMA callback side: the callback started at start (cycle counter)
+    // -------------------------------------------------------------------------
+    inline void IsrDone(uint32_t start)
+    {
+        uint32_t cycles = CycleCounterGet() - start;
+        m_IsrCycles.store(m_IsrCycles.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+    }
+
+    // -------------------------------------------------------------------------
+    // Audio task side: run start / end
+    // -------------------------------------------------------------------------
+    inline void TaskBegin()
+    {
+        m_TaskIsrStart = m_IsrCycles.load(std::memory_order_relaxed);
+        m_TaskStart = CycleCounterGet();
+    }
+    inline void TaskDone()
+    {
+        uint32_t cycles = CycleCounterGet() - m_TaskStart;
+        uint32_t preempted = m_IsrCycles.load(std::memory_order_relaxed) - m_TaskIsrStart;
+        m_TaskCycles.store(m_TaskCycles.load(std::memory_order_relaxed) + cycles - preempted, std::memory_order_relaxed);
+    }
+
+    // -------------------------------------------------------------------------
+    // Block mixer side (audio task, or TX callback with pullSamples): the
+    // block requested by the TX callback at txTimestamp is done
+    // -------------------------------------------------------------------------
+    inline void BlockDone(uint32_t txTimestamp)
+    {
+        uint32_t elapsed = CycleCounterGet() - txTimestamp;
+        if (elapsed > m_BlockElapsedMax) m_BlockElapsedMax = elapsed;
+        if (elapsed > m_TxPeriod) m_DeadlineMiss++;
+    }
+    inline void resetBlockPeak() { m_BlockElapsedMax = 0; }
+
+    // -------------------------------------------------------------------------
+    // Main loop: closes the current window when CPU_LOAD_WINDOW_MS elapsed.
+    // Call at least every few windows (a longer pass makes one longer window).
+    // -------------------------------------------------------------------------
+    void Update();
+
+    // -------------------------------------------------------------------------
+    // Main loop: starts a new window load peak (the block peak is restarted by
+    // the block mixer side, see cMixer::resetPeaks)
+    // -------------------------------------------------------------------------
+    void resetPeak() { m_PeakLoad = m_Load; }
+
+    // -------------------------------------------------------------------------
+    // Loads in per mille of the CPU (window, last second, peak window)
+    // -------------------------------------------------------------------------
+    uint32_t getLoad() const { return m_Load; }
+    uint32_t getAverageLoad() const { return m_AverageLoad; }
+    uint32_t getPeakLoad() const { return m_PeakLoad; }
+
+    // -------------------------------------------------------------------------
+    // Blocks done after their deadline, latest finish since the last block
+    // peak restart in per mille of the TX period
+    // -------------------------------------------------------------------------
+    uint32_t getDeadlineMissCount() const { return m_DeadlineMiss; }
+    uint32_t getDeadlineUse() const;
+
+    // -------------------------------------------------------------------------
+    // Busy cycles of the audio interrupts since Init (wrapping)
+    // -------------------------------------------------------------------------
+    uint32_t getBusyCycles() const
+    {
+        return m_IsrCycles.load(std::memory_order_relaxed) + m_TaskCycles.load(std::memory_order_relaxed);
+    }
+
+private:
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+
+    // Audio interrupts
+    std::atomic<uint32_t> m_IsrCycles;  // DMA callbacks busy cycles
+    std::atomic<uint32_t> m_TaskCycles; // Audio task busy cycles, preemption excluded
+    uint32_t m_TaskStart;               // Current audio task run
+    uint32_t m_TaskIsrStart;            // m_IsrCycles at its start
+    uint32_t m_TxPeriod;                // Block deadline (CPU cycles)
+    uint32_t m_BlockElapsedMax;         // Latest block finish after its TX callback
+    uint32_t m_DeadlineMiss;            // Blocks finished after the next TX callback
+
+    // Main loop
+    uint32_t m_WindowCycles;            // CPU_LOAD_WINDOW_MS in CPU cycles
+    uint32_t m_WindowStart;             // Cycle counter at the window start
+    uint32_t m_WindowBusy;              // Busy cycles at the window start
+    uint32_t m_SecondLength;            // 1 s in CPU cycles
+    uint64_t m_SecondCycles;            // Cycles and busy cycles of the
+    uint64_t m_SecondBusy;              // windows in the current second
+    uint32_t m_Load;                    // Per mille
+    uint32_t m_AverageLoad;
+    uint32_t m_PeakLoad;
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
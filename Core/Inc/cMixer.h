@@ -1,7 +1,7 @@
 //==================================================================================
 //==================================================================================
 // File: cMixer.h
-// Description: Header for 3-channel asynchronous S/PDIF audio mixer with adaptive
+// Description: Header for N-channel asynchronous S/PDIF audio mixer with adaptive
 //              drift compensation and sample rate conversion to 48kHz
 //
 // Copyright (c) 2025 Dad Design.
@@ -10,23 +10,88 @@
 #pragma once
 
 #include "main.h"
+#include "cPolyphaseSinc.h"
+#include "cRateEstimator.h"
+#include "cSPSCQueue.h"
+#include "cParamBlock.h"
+#include "cCapture.h"
+#include "cCpuLoad.h"
 #include <algorithm>
+#include <atomic>
 
 // =============================================================================
 // Configuration constants
 // =============================================================================
 
-#define CIRCULAR_BUFFER_SIZE 200      // Size of circular buffer in stereo samples
-#define RX_BUFFER_SIZE 20             // Input buffer size in stereo samples
-#define TX_BUFFER_SIZE 10             // Output buffer size in stereo samples
-#define DRIF_CALC_NB_SAMPLES 1000     // Number of samples between drift calculations
-
-// Sample rate detection deltas (for DRIF_CALC_NB_SAMPLES samples)
-#define DELTA_DATE_96000 1995         // Expected delta for 96kHz
-#define DELTA_DATE_48000 995          // Expected delta for 48kHz
-#define DELTA_DATE_44100 915          // Expected delta for 44.1kHz
-#define DELTA_DATE_41000 855          // Expected delta for 41kHz
-#define DELTA_DATE_32000 665          // Expected delta for 32kHz
+// Block sizes of the latency / CPU profile (AUDIO_PROFILE, see Options.h)
+// The receivers DMA straight into the ring, whose write position is read
+// from the DMA counter at each TX callback. The ring must hold twice the
+// deepest read (target age, a TX block at ratio 2, the DMA progress while the
+// block is waiting to be mixed) plus the longest kernel.
+#if AUDIO_PROFILE == AUDIO_PROFILE_ULTRA_LOW_LATENCY
+#define TX_NB_FRAMES 5                // Stereo frames produced per TX callback
+#define CIRCULAR_BUFFER_SIZE 256      // Size of circular buffer in stereo samples (power of two)
+#define SYNC_TIMEOUT_MS 5             // Input whose DMA stalls this long is unsynchronized
+#elif AUDIO_PROFILE == AUDIO_PROFILE_BALANCED
+#define TX_NB_FRAMES 16
+#define CIRCULAR_BUFFER_SIZE 512
+#define SYNC_TIMEOUT_MS 8
+#elif AUDIO_PROFILE == AUDIO_PROFILE_LOW_CPU
+#define TX_NB_FRAMES 64
+#define CIRCULAR_BUFFER_SIZE 2048
+#define SYNC_TIMEOUT_MS 16
+#else
+#error "Unknown AUDIO_PROFILE"
+#endif
+
+#define TX_BUFFER_SIZE (TX_NB_FRAMES * 2)  // Output buffer size in samples (interleaved L/R)
+#define CIRCULAR_BUFFER_SAMPLES (CIRCULAR_BUFFER_SIZE * 2)  // Ring storage in samples (DMA target, interleaved L/R)
+#define CIRCULAR_BUFFER_MASK (CIRCULAR_BUFFER_SIZE - 1)
+#define RX_MARK_FRAMES (CIRCULAR_BUFFER_SIZE / 2)  // Frames between RX DMA half / complete callbacks
+#define CIRCULAR_BUFFER_MARGIN (4 * TX_NB_FRAMES)  // DMA progress between a position capture and the read (frames)
+#define PULL_WINDOW_FRAMES (3 * TX_NB_FRAMES + SINC_MAX_TAPS)  // Frames read for one TX block (ratio < 2.5)
+#define PULL_CACHE_FRAMES (4 * PULL_WINDOW_FRAMES)  // Converted frames kept (compacted when full)
+#define FILL_TARGET (2 * TX_NB_FRAMES)     // Drift loop target age (frames behind the write position)
+
+static_assert(CIRCULAR_BUFFER_SIZE >= 2 * (FILL_TARGET + 2 * TX_NB_FRAMES + CIRCULAR_BUFFER_MARGIN) + SINC_MAX_TAPS,
+              "CIRCULAR_BUFFER_SIZE too small for the profile block sizes");
+
+// Input synchronization (rate measured from the callback timestamps)
+#define SYNC_RATE_TOLERANCE 0.01      // Max relative distance to a standard rate
+#define RATE_EST_WINDOW_FRAMES 10240  // Rate regression time constant (stream frames)
+#define RATE_EST_MIN_FRAMES 320       // Output frames before the output rate estimate is valid
+#define RATE_EST_MIN_CALLBACKS 8      // Lower bound of the valid output estimate (callbacks)
+#define RATE_EST_MIN_WINDOW 16        // Lower bound of the regression time constant (callbacks)
+#define RATE_EST_MIN_MARKS 3          // RX half / complete callbacks before the input estimate is valid
+
+// Interrupt / audio task hand-off queues
+#define RX_MARK_QUEUE_DEPTH 4         // RX DMA callback timestamps queued per input
+#define TX_QUEUE_DEPTH 4              // Mixed blocks (and TX requests) queued
+#define TX_QUEUE_PREFILL 2            // Mixed blocks kept ahead of the TX callback
+
+// Stream event log (underruns, overruns and resyncs of the inputs)
+#define STREAM_EVENT_DEPTH 32         // Latest events kept (power of two)
+
+// Drift control loop (type-2 PLL on the buffer fill level, with the rate
+// ratio measured from the DMA callback timestamps as feed-forward)
+#define PLL_ACQUIRE_BW 5.0            // Loop bandwidth while acquiring (Hz)
+#define PLL_TRACK_BW 0.1              // Loop bandwidth once locked (Hz)
+#define PLL_DAMPING 0.707             // Loop damping factor
+#define PLL_FILTER_RATIO 8.0          // Error pre-filter corner / loop bandwidth
+#define PLL_LOCK_ERROR (FILL_TARGET * 0.15)    // Filtered fill error to declare lock (frames)
+#define PLL_UNLOCK_ERROR (FILL_TARGET * 0.6)   // Filtered fill error to declare lock loss (frames)
+#define PLL_LOCK_TIME 12000           // Output frames within PLL_LOCK_ERROR before tracking
+#define PLL_MAX_DEVIATION 0.02        // Ratio correction clamp (relative to nominal)
+
+// Interpolation CPU budget (share of one TX callback period, all inputs)
+#define INTERPOLATION_BUDGET_PERCENT 50
+#define KERNEL_FADE_FRAMES 48         // Crossfade from the previous kernel after a switch (frames)
+#define OUTPUT_SAMPLE_RATE 48000      // Output sample rate (TX callback period base)
+
+// Fixed-point read position format (32.32: integer frame date / fraction)
+#define PHASE_FRAC_BITS 32
+constexpr double PHASE_ONE = 4294967296.0;           // 1.0 in 32.32
+constexpr float PHASE_FRAC_TO_FLOAT = 1.0f / 4294967296.0f;
 
 // Normalization coefficients for 24-bit to float conversion
 constexpr float COEF_NORMALIZE = 1.0f / 8388607.0f;  // 0x7FFFFF (max 24-bit positive)
@@ -51,71 +116,289 @@ enum class eSampleRate
     NoSync      // No synchronization detected
 };
 
+// -----------------------------------------------------------------------------
+// Interpolation kernels used by cCircularBuff::Pull (increasing cost)
+// -----------------------------------------------------------------------------
+enum class eInterpolation : uint8_t
+{
+    Linear,     // Two taps linear interpolation
+    Cubic,      // Four taps cubic Hermite (Farrow structure)
+    Sinc16,     // 16 taps polyphase windowed-sinc
+    Sinc32,     // 32 taps polyphase windowed-sinc
+    Sinc64      // 64 taps polyphase windowed-sinc
+};
+constexpr uint8_t NB_INTERPOLATIONS = 5;
+
+// -----------------------------------------------------------------------------
+// Drift control loop state of an input
+// -----------------------------------------------------------------------------
+enum class eLockState : uint8_t
+{
+    NoSync,     // Input not synchronized, loop idle
+    Acquire,    // Wide bandwidth, converging to the source rate
+    Track       // Locked, narrow bandwidth
+};
+
+// -----------------------------------------------------------------------------
+// Input stream events (cMixer event log)
+// -----------------------------------------------------------------------------
+enum class eStreamEvent : uint8_t
+{
+    Underrun,   // Read position ahead of the DMA: frames not received yet, silence
+    Overrun,    // Read position behind the ring: frames overwritten by the DMA, silence
+    Resync      // Receiver restarted its DMA (error callback)
+};
+
+// =============================================================================
+// Structures
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+// Stream event, with the input and drift loop state when it was detected
+// -----------------------------------------------------------------------------
+struct sStreamEvent
+{
+    uint32_t Timestamp;         // CPU cycles (DWT) of the TX callback, or of the error callback for Resync
+    uint32_t OutDate;           // Output frames produced before the block
+    float FillLevel;            // Age of the read position (frames, before the block)
+    float LoopError;            // Filtered fill error of the drift loop (frames)
+    float DriftFactor;          // Input frames per output frame
+    uint16_t Frames;            // Frames read out of the ring in the block (Underrun / Overrun)
+    uint8_t Input;
+    eStreamEvent Type;
+    eLockState LockState;
+};
+
+// -----------------------------------------------------------------------------
+// Drift state of an input, published by the audio path after each block
+// -----------------------------------------------------------------------------
+struct sInputStatus
+{
+    double DriftFactor;         // Input frames per output frame (0 = not synchronized)
+    double MeasuredRatio;       // Ratio from the callback timestamps (0 = not valid)
+    float BufferAge;            // Age of the read position (frames)
+    float LoopError;            // Filtered fill error of the drift loop (frames)
+    eLockState LockState;
+};
+
+//**********************************************************************************
+// cInputStream
+// Receiver side of a mixer input: the receiver DMA writes the ring storage
+// in circular mode, the mixer reads its progress at each TX callback. The
+// half / complete callbacks only timestamp the ring halves (markInput).
+//**********************************************************************************
+class cInputStream
+{
+public:
+    virtual ~cInputStream() {}
+
+    // -------------------------------------------------------------------------
+    // DMA transfer counter (NDTR): samples left before the ring wraps
+    // -------------------------------------------------------------------------
+    virtual uint32_t getRemaining() const = 0;
+
+    // -------------------------------------------------------------------------
+    // False while the receiver reports no valid audio (input muted)
+    // -------------------------------------------------------------------------
+    virtual bool isValid() const = 0;
+};
+
 //**********************************************************************************
 // cCircularBuff
-// Circular buffer with linear interpolation for audio samples
+// Circular buffer with linear, cubic or polyphase sinc interpolation for audio samples
+// The storage is the receiver DMA target and holds raw signed 24-bit
+// samples, indexed by frame date & CIRCULAR_BUFFER_MASK. Frames are converted
+// to float only when a kernel first reads them, into a linear cache, so the
+// kernels read a contiguous window and never see the ring wrap.
 //**********************************************************************************
+static_assert((CIRCULAR_BUFFER_SIZE & CIRCULAR_BUFFER_MASK) == 0, "CIRCULAR_BUFFER_SIZE must be a power of two");
+
 class cCircularBuff
 {
 public:
     // =========================================================================
     // Constructor
     // -------------------------------------------------------------------------
-    cCircularBuff() { Clear(); }
+    cCircularBuff() : m_pRing(nullptr), m_Interpolation(eInterpolation::Linear), m_pSinc(nullptr) { Clear(); ClearCounters(); }
 
     // =========================================================================
     // Public methods
     // -------------------------------------------------------------------------
 
+    // -------------------------------------------------------------------------
+    // Sets the ring storage (CIRCULAR_BUFFER_SAMPLES samples, written by the DMA)
+    // -------------------------------------------------------------------------
+    inline void setStorage(int32_t* pRing) { m_pRing = pRing; }
+    inline bool hasStorage() const { return m_pRing != nullptr; }
+    inline const int32_t* getStorage() const { return m_pRing; }
+
     // -------------------------------------------------------------------------
     // Clears buffer and resets state
     // -------------------------------------------------------------------------
     void Clear()
     {
-        m_pBuffer = m_Buffer;     // Reset buffer pointer to start
-        m_Date = 0.0;             // Reset internal timestamp
+        m_Date = 0;               // Reset internal timestamp (and write index)
+        m_CacheDate = 0;          // Drop the converted frames
+        m_CacheEnd = 0;
+        m_CacheFrames = 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Frames read out of the ring since ClearCounters (returned as silence):
+    // underrun when not written yet, overrun when already overwritten.
+    // Clear keeps them.
+    // -------------------------------------------------------------------------
+    inline void ClearCounters() { m_UnderrunFrames = 0; m_OverrunFrames = 0; }
+    inline uint32_t getUnderrunFrames() const { return m_UnderrunFrames; }
+    inline uint32_t getOverrunFrames() const { return m_OverrunFrames; }
+
+    // -------------------------------------------------------------------------
+    // Gets current buffer date (frames written, wraps at 2^32)
+    // -------------------------------------------------------------------------
+    inline uint32_t getDate() const { return m_Date; }
+
+    // -------------------------------------------------------------------------
+    // Advances the date to the ring frame index written next by the DMA.
+    // Must be called at least once per ring lap.
+    // -------------------------------------------------------------------------
+    inline void setWriteIndex(uint32_t frameIndex)
+    {
+        m_Date += (frameIndex - m_Date) & CIRCULAR_BUFFER_MASK;
+    }
+
+    // -------------------------------------------------------------------------
+    // Gets read phase (32.32) lying age frames behind the write date
+    // -------------------------------------------------------------------------
+    inline uint64_t getPhase(uint32_t age) const
+    {
+        return static_cast<uint64_t>(m_Date - age) << PHASE_FRAC_BITS;
     }
 
     // -------------------------------------------------------------------------
-    // Gets current buffer date (timestamp)
+    // Gets age in frames of a read phase (write date - read position)
     // -------------------------------------------------------------------------
-    inline double getDate() const { return m_Date; }
+    inline float getAge(uint64_t phase) const
+    {
+        int32_t intAge = static_cast<int32_t>(m_Date - static_cast<uint32_t>(phase >> PHASE_FRAC_BITS));
+        return intAge - static_cast<uint32_t>(phase) * PHASE_FRAC_TO_FLOAT;
+    }
 
     // -------------------------------------------------------------------------
-    // Sets buffer date (timestamp)
+    // Selects the kernel used by Pull (pSinc is the bank for Sinc kernels)
     // -------------------------------------------------------------------------
-    inline void setDate(double newDate) { m_Date = newDate; }
+    inline void setInterpolator(eInterpolation interpolation, const cPolyphaseSinc* pSinc)
+    {
+        m_Interpolation = interpolation;
+        m_pSinc = pSinc;
+    }
+    inline eInterpolation getInterpolator() const { return m_Interpolation; }
 
     // -------------------------------------------------------------------------
-    // Pushes signed 24-bit samples (interleaved L/R)
+    // Pulls interpolated samples at given 32.32 read phase
     // -------------------------------------------------------------------------
-    void Push(int32_t *pSamples);
+    void Pull(float *pSamples, uint64_t phase);
 
     // -------------------------------------------------------------------------
-    // Pulls interpolated samples at given date
+    // Pulls a block of interpolated frames, advancing phase by increment
+    // after each frame (nbFrames <= TX_NB_FRAMES)
     // -------------------------------------------------------------------------
-    void Pull(float *pSamples, double date);
+    void PullBlock(float *pSamples, uint64_t& phase, uint64_t increment, uint32_t nbFrames);
 
 private:
+    // =========================================================================
+    // Private methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Points m_pWindow to nbFrames converted frames from date, converting
+    // only the frames not already in the cache
+    // -------------------------------------------------------------------------
+    void Convert(uint32_t date, uint32_t nbFrames);
+
+    // -------------------------------------------------------------------------
+    // Interpolates one frame at window frame index with fractional position
+    // -------------------------------------------------------------------------
+    inline void Interpolate(float *pSamples, uint32_t frameIndex, float frac) const;
+
+    // -------------------------------------------------------------------------
+    // Kernels (window ends on the frame following frameIndex)
+    // -------------------------------------------------------------------------
+    inline void InterpolateLinear(float *pSamples, uint32_t frameIndex, float frac) const;
+    inline void InterpolateCubic(float *pSamples, uint32_t frameIndex, float frac) const;
+    inline void InterpolateSinc(float *pSamples, uint32_t frameIndex, float frac) const;
+
+    // -------------------------------------------------------------------------
+    // Number of frames read by the kernel, ending on the frame following the
+    // integer date
+    // -------------------------------------------------------------------------
+    inline uint32_t getHistory() const
+    {
+        switch (m_Interpolation)
+        {
+            case eInterpolation::Linear: return 2;
+            case eInterpolation::Cubic:  return 4;
+            default:                     return m_pSinc->getNbTaps();
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Checks that all frames read at integer age are written and cannot be
+    // overwritten by the DMA before they are converted
+    // -------------------------------------------------------------------------
+    inline bool isInRange(int32_t intAge) const
+    {
+        return (intAge >= 2) &&
+               (intAge <= static_cast<int32_t>(CIRCULAR_BUFFER_SIZE - CIRCULAR_BUFFER_MARGIN + 2 - getHistory()));
+    }
+
     // =========================================================================
     // Member variables
     // -------------------------------------------------------------------------
-    float m_Buffer[CIRCULAR_BUFFER_SIZE * 2];  // Stereo interleaved buffer
-    float* m_pBuffer;                          // Current write pointer
-    double m_Date;                             // Internal timestamp
+    int32_t* m_pRing;                          // Raw stereo interleaved ring (DMA target)
+    float m_Cache[PULL_CACHE_FRAMES * 2];      // Converted frames, in date order
+    const float* m_pWindow;                    // Frames of the current read, in m_Cache
+    uint32_t m_CacheDate;                      // Date following the last converted frame
+    uint32_t m_CacheEnd;                       // Cache frame index following the last converted frame
+    uint32_t m_CacheFrames;                    // Converted frames ending at m_CacheEnd
+    uint32_t m_Date;                           // Internal timestamp (frames written)
+    eInterpolation m_Interpolation;            // Selected kernel
+    const cPolyphaseSinc* m_pSinc;             // Sinc bank (Sinc kernels only)
+    uint32_t m_UnderrunFrames;                 // Frames read before being written
+    uint32_t m_OverrunFrames;                  // Frames read after being overwritten
+};
+
+// -----------------------------------------------------------------------------
+// Block exchanged between the audio task and the TX DMA callback
+// -----------------------------------------------------------------------------
+struct sTxBlock
+{
+    int32_t Samples[TX_BUFFER_SIZE];    // Mixed block
 };
 
 //**********************************************************************************
 // cMixer
-// 3-channel mixer with adaptive drift compensation
+// NbInputs-channel mixer with adaptive drift compensation
+// Per input state is stored as arrays indexed by input (struct-of-arrays), all
+// per input loops have the compile-time bound NbInputs.
+// The receivers DMA straight into the input rings. The TX DMA callback
+// exchanges a mixed block for a TX request (fetchSamples) holding the DMA
+// position of every input at that time, the RX DMA callbacks only queue the
+// timestamp of each ring half (markInput) for the rate estimates. Process,
+// run from a low priority software interrupt, consumes the requests and mixes
+// TX_QUEUE_PREFILL blocks ahead of the TX callback. pullSamples remains
+// available for synchronous use (host bench).
 //**********************************************************************************
+template <uint8_t NbInputs>
 class cMixer
 {
 public:
+    static_assert(NbInputs > 0, "cMixer needs at least one input");
+    static constexpr uint8_t NB_INPUTS = NbInputs;
+
     // =========================================================================
     // Constructor
     // -------------------------------------------------------------------------
-    cMixer() { Initialise(); }
+    cMixer();
 
     // =========================================================================
     // Public methods
@@ -127,127 +410,464 @@ public:
     void Initialise();
 
     // -------------------------------------------------------------------------
-    // Sample rate getters
+    // Attaches the ring storage (CIRCULAR_BUFFER_SAMPLES samples, circular DMA
+    // target) and the receiver of an input. Call before the DMA is started.
+    // -------------------------------------------------------------------------
+    void attachInput(uint8_t input, int32_t* pRing, const cInputStream* pStream);
+
+    // -------------------------------------------------------------------------
+    // Sample rate getter (input < NbInputs)
+    // -------------------------------------------------------------------------
+    eSampleRate GetSampleRate(uint8_t input) const { return m_SampleRate[input]; }
+
+    // -------------------------------------------------------------------------
+    // Source rate reported by the receiver (Hz, 0 = unknown). Lets the input
+    // start on its first blocks, before the timestamp estimate is valid.
+    // -------------------------------------------------------------------------
+    void setSourceRate(uint8_t input, uint32_t sampleRate) { m_SourceRate[input] = sampleRate; }
+
+    // -------------------------------------------------------------------------
+    // Drift factor (input frames read per output frame, 0 = not synchronized)
+    // and buffer fill level (age of the read position in frames)
+    // -------------------------------------------------------------------------
+    double getDriftFactor(uint8_t input) const { return m_DriftFactor[input]; }
+    float getBufferAge(uint8_t input) const { return m_Buffer[input].getAge(m_ReadPhase[input]); }
+
+    // -------------------------------------------------------------------------
+    // Drift control loop state and filtered fill level error (frames)
+    // -------------------------------------------------------------------------
+    eLockState getLockState(uint8_t input) const { return m_LockState[input]; }
+    float getLoopError(uint8_t input) const { return m_LoopError[input]; }
+
+    // -------------------------------------------------------------------------
+    // Rate ratio measured from the callback timestamps (input frames per
+    // output frame, 0 until both estimates are valid)
+    // -------------------------------------------------------------------------
+    double getMeasuredRatio(uint8_t input) const;
+
+    // -------------------------------------------------------------------------
+    // The getters above read the audio path state as it is being updated
+    // (audio path, or a stopped mixer). Other contexts copy the set published
+    // at the end of the latest block: fetchStatus (one reader context)
+    // returns false and keeps status when no block was mixed since the
+    // previous fetch.
+    // -------------------------------------------------------------------------
+    struct sStatus
+    {
+        sInputStatus Input[NbInputs];
+    };
+    bool fetchStatus(sStatus& status) { return m_Status.Fetch(status); }
+
+    // -------------------------------------------------------------------------
+    // Sets the drift control loop bandwidths (Hz) for acquisition and tracking
+    // -------------------------------------------------------------------------
+    void setLoopBandwidth(float acquireHz, float trackHz);
+
+    // -------------------------------------------------------------------------
+    // Gain setters (control side, see m_Params). The audio task applies the
+    // new set at the start of its next block.
+    // -------------------------------------------------------------------------
+    void setGain(uint8_t input, float gain);   // Set input gain
+    void setGainMaster(float gain);            // Set master gain
+
+    // -------------------------------------------------------------------------
+    // Per input interpolation kernel. A selection is refused (returns false,
+    // previous kernel kept) when the measured cost of all kernels would
+    // exceed the interpolation budget of a TX callback. It is applied by the
+    // audio task at the start of the next block.
+    // -------------------------------------------------------------------------
+    bool setInterpolation(uint8_t input, eInterpolation interp);
+    eInterpolation getInterpolation(uint8_t input) const { return m_Params.getEdit().Interpolation[input]; }
+
+    // -------------------------------------------------------------------------
+    // Measures the cost of each kernel with the DWT cycle counter. Call once
+    // after clock configuration and attachInput, before the audio streams are
+    // started. Selected kernels over the budget are stepped down.
+    // -------------------------------------------------------------------------
+    void MeasureInterpolationCost();
+
+    // -------------------------------------------------------------------------
+    // Kernel cost in CPU cycles per stereo frame (measured or estimated)
+    // and interpolation budget in CPU cycles per TX callback
+    // -------------------------------------------------------------------------
+    uint32_t getInterpolationCycles(eInterpolation interp) const { return m_InterpolationCycles[static_cast<uint8_t>(interp)]; }
+    uint32_t getInterpolationBudget() const;
+
+    // -------------------------------------------------------------------------
+    // DMA callback side, timestamp is the DWT cycle counter read at the start
+    // of the callback
+    // -------------------------------------------------------------------------
+    void markInput(uint8_t input, uint32_t frameIndex, uint32_t timestamp);  // RX ring written up to frameIndex
+    void fetchSamples(int32_t* pSamples, uint32_t timestamp);                // Get the next mixed block, request a new one
+
+    // -------------------------------------------------------------------------
+    // Audio task: mixes one block per TX request
+    // -------------------------------------------------------------------------
+    void Process();
+
+    // -------------------------------------------------------------------------
+    // Hand-off errors: RX timestamps dropped (queue full), TX blocks sent as
+    // silence (audio task late) and TX requests dropped (request queue full,
+    // the block is never mixed)
     // -------------------------------------------------------------------------
-    eSampleRate GetSampleRate1() const { return m_SampleRate1; }  // Input 1 sample rate
-    eSampleRate GetSampleRate2() const { return m_SampleRate2; }  // Input 2 sample rate
-    eSampleRate GetSampleRate3() const { return m_SampleRate3; }  // Input 3 sample rate
+    uint32_t getRxOverflowCount(uint8_t input) const { return m_RxOverflow[input]; }
+    uint32_t getTxUnderrunCount() const { return m_TxUnderrun; }
+    uint32_t getTxRequestOverflowCount() const { return m_TxRequestOverflow; }
+
+    // -------------------------------------------------------------------------
+    // CPU cycles of the latest / longest block mix (cache and memory layout
+    // comparisons)
+    // -------------------------------------------------------------------------
+    uint32_t getMixCycles() const { return m_MixCycles; }
+    uint32_t getMixCyclesMax() const { return m_MixCyclesMax; }
+
+    // -------------------------------------------------------------------------
+    // CPU load of the DMA callbacks and the audio task, TX deadline misses
+    // (see cCpuLoad). updateCpuLoad closes the load windows, main loop.
+    // -------------------------------------------------------------------------
+    void updateCpuLoad() { m_CpuLoad.Update(); }
+    const cCpuLoad& getCpuLoad() const { return m_CpuLoad; }
+
+    // -------------------------------------------------------------------------
+    // Peak levels since the last resetPeaks (1.0 = full scale): inputs before
+    // their gain, output after the master gain. Output blocks clipped.
+    // resetPeaks (control side) is applied by the audio task at the start of
+    // its next block, it also restarts the CPU load and deadline peaks.
+    // -------------------------------------------------------------------------
+    float getPeak(uint8_t input) const { return m_Peak[input]; }
+    float getPeakOut() const { return m_PeakOut; }
+    uint32_t getClipCount() const { return m_ClipCount; }
+    void resetPeaks()
+    {
+        m_CpuLoad.resetPeak();
+        m_PeakReset.store(m_PeakReset.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
 
     // -------------------------------------------------------------------------
-    // Channel gain setters
+    // Stream errors (DMA error callback side, timestamp as for markInput)
+    // resyncInput: the receiver restarted its DMA, the audio task drops the
+    // input state at its next block and resynchronizes it like a new stream.
+    // restartOutput: the TX DMA restarted, the output rate estimate is reset.
     // -------------------------------------------------------------------------
-    void setGain1(float gain) { m_Gain1 = gain; }           // Set input 1 gain
-    void setGain2(float gain) { m_Gain2 = gain; }           // Set input 2 gain
-    void setGain3(float gain) { m_Gain3 = gain; }           // Set input 3 gain
-    void setGainMaster(float gain) { m_GainMaster = gain; } // Set master gain
+    void resyncInput(uint8_t input, uint32_t timestamp);
+    void restartOutput();
 
     // -------------------------------------------------------------------------
-    // Sample input/output methods
+    // Error counters and recovery time: CPU cycles from the resyncInput
+    // call to the first block mixed again (latest and longest)
     // -------------------------------------------------------------------------
-    void pushSamples1(int32_t* pSamples);  // Push samples to input 1
-    void pushSamples2(int32_t* pSamples);  // Push samples to input 2
-    void pushSamples3(int32_t* pSamples);  // Push samples to input 3
-    void pullSamples(int32_t* pSamples);   // Pull mixed samples from all inputs
+    uint32_t getResyncCount(uint8_t input) const { return m_ResyncRequest[input].load(std::memory_order_relaxed); }
+    uint32_t getTxRestartCount() const { return m_TxRestart.load(std::memory_order_relaxed); }
+    uint32_t getRecoveryCycles(uint8_t input) const { return m_RecoveryCycles[input]; }
+    uint32_t getRecoveryCyclesMax(uint8_t input) const { return m_RecoveryCyclesMax[input]; }
+
+    // -------------------------------------------------------------------------
+    // Input starvation: blocks that started an underrun / overrun (a run of
+    // consecutive blocks is one event) and frames returned as silence
+    // -------------------------------------------------------------------------
+    uint32_t getUnderrunCount(uint8_t input) const { return m_UnderrunCount[input]; }
+    uint32_t getOverrunCount(uint8_t input) const { return m_OverrunCount[input]; }
+    uint32_t getUnderrunFrames(uint8_t input) const { return m_Buffer[input].getUnderrunFrames(); }
+    uint32_t getOverrunFrames(uint8_t input) const { return m_Buffer[input].getOverrunFrames(); }
+
+    // -------------------------------------------------------------------------
+    // Event log, written by the audio task: events are numbered from 0 in
+    // order, the latest STREAM_EVENT_DEPTH are kept. getEvent copies event
+    // number index and returns false when it was overwritten (or during the
+    // copy) or is not logged yet.
+    // -------------------------------------------------------------------------
+    uint32_t getEventCount() const { return m_EventCount.load(std::memory_order_acquire); }
+    bool getEvent(uint32_t index, sStreamEvent& event) const;
+
+    // -------------------------------------------------------------------------
+    // Synchronous output: captures the input positions and mixes a block
+    // -------------------------------------------------------------------------
+    void pullSamples(int32_t* pSamples, uint32_t timestamp);
+
+    // -------------------------------------------------------------------------
+    // Records every block into pCapture while it is recording (see
+    // cCapture.h), after writing the stream header; nullptr detaches it.
+    // Call after Initialise, before the DMAs are started.
+    // -------------------------------------------------------------------------
+    void attachCapture(cCapture* pCapture);
 
 private:
+    // -------------------------------------------------------------------------
+    // TX callback time and DMA positions of the inputs (ring frame written
+    // next, STREAM_MUTED when the receiver reports no valid audio)
+    // -------------------------------------------------------------------------
+    static constexpr uint32_t STREAM_MUTED = 0xFFFFFFFF;
+    struct sTxRequest
+    {
+        uint32_t Timestamp;                 // TX callback timestamp
+        uint32_t WriteIndex[NbInputs];      // Input positions at Timestamp
+    };
+
+    // -------------------------------------------------------------------------
+    // RX DMA half / complete callback: ring frame index reached at Timestamp
+    // -------------------------------------------------------------------------
+    struct sRxMark
+    {
+        uint32_t Timestamp;
+        uint32_t FrameIndex;
+    };
+
     // =========================================================================
     // Private methods
     // -------------------------------------------------------------------------
 
     // -------------------------------------------------------------------------
-    // Detects sample rate from sample count
+    // Reads the DMA positions of the inputs (TX callback) / applies them and
+    // the queued RX timestamps to the rings and the rate estimates (audio task)
+    // -------------------------------------------------------------------------
+    void captureInputs(sTxRequest& request, uint32_t timestamp) const;
+    void updateInputs(const sTxRequest& request);
+
+    // -------------------------------------------------------------------------
+    // Mixes one block for a TX request
+    // -------------------------------------------------------------------------
+    void mixBlock(int32_t* pSamples, const sTxRequest& request);
+
+    // -------------------------------------------------------------------------
+    // Steps the selected kernels down until they fit the budget (start-up)
+    // -------------------------------------------------------------------------
+    void fitInterpolation();
+
+    // -------------------------------------------------------------------------
+    // Publishes the drift state of the inputs after a block (fetchStatus)
     // -------------------------------------------------------------------------
-    eSampleRate detectSampleRate(uint16_t sampleCount);
+    void publishStatus();
+
+    // -------------------------------------------------------------------------
+    // Capture record of the block: TX request and parameters / received
+    // frames of an input / output and drift state hashes
+    // -------------------------------------------------------------------------
+    void captureRequest(const sTxRequest& request, uint8_t flags);
+    void captureFrames(uint8_t input, uint32_t fromDate);
+    void captureHashes(const int32_t* pSamples);
+
+    // -------------------------------------------------------------------------
+    // Matches a measured rate (Hz) to a standard sample rate
+    // -------------------------------------------------------------------------
+    eSampleRate detectSampleRate(double sampleRate) const;
 
     // -------------------------------------------------------------------------
     // Converts sample rate enum to frequency value
     // -------------------------------------------------------------------------
-    float getSampleRate(eSampleRate sr);
+    float getSampleRate(eSampleRate sr) const;
 
     // -------------------------------------------------------------------------
-    // Updates buffer synchronization parameters
+    // Gets the sinc bank of a kernel (nullptr for linear and cubic)
     // -------------------------------------------------------------------------
-    void updateBufferSync(
-        uint16_t& ctIN,               // Input sample counter
-        eSampleRate& currentRate,     // Current sample rate
-        float& nominalFactor,         // Nominal resampling factor
-        float& driftFactor,           // Current drift compensation factor
-        cCircularBuff& buffer,        // Circular buffer
-        double& dateOut               // Output date
-    );
+    const cPolyphaseSinc* getSincBank(eInterpolation interp) const;
+
+    // -------------------------------------------------------------------------
+    // Updates synchronization parameters of an input (once per TX block)
+    // -------------------------------------------------------------------------
+    void updateBufferSync(uint8_t input);
+
+    // -------------------------------------------------------------------------
+    // Starts an input at a sample rate with a seeded ratio / stops an input
+    // -------------------------------------------------------------------------
+    void startInput(uint8_t input, eSampleRate sr, double ratio);
+    void stopInput(uint8_t input);
+
+    // -------------------------------------------------------------------------
+    // Logs a stream event with the current drift loop state of the input
+    // -------------------------------------------------------------------------
+    void logEvent(uint8_t input, eStreamEvent type, uint32_t timestamp, float fillLevel, uint32_t frames);
+
+    // -------------------------------------------------------------------------
+    // Computes the loop coefficients of one mode for a bandwidth (Hz)
+    // -------------------------------------------------------------------------
+    void setLoopGains(uint8_t mode, double bandwidthHz);
 
     // -------------------------------------------------------------------------
-    // Adjusts drift factor based on buffer fill level
+    // Resets the drift control loop of an input
+    // -------------------------------------------------------------------------
+    void resetLoop(uint8_t input, eLockState state);
+
+    // -------------------------------------------------------------------------
+    // Buffer fill level at the current TX callback (frames), measured from
+    // the estimated continuous write position when available
+    // -------------------------------------------------------------------------
+    double getFillLevel(uint8_t input, uint64_t readPhase) const;
+
+    // -------------------------------------------------------------------------
+    // Runs the drift control loop of an input on the buffer fill level (once
+    // per block)
     // -------------------------------------------------------------------------
     void adjustDrift(
-        float& driftFactor,            // Current drift factor to adjust
-        float nominalFactor,           // Nominal resampling factor
-        const cCircularBuff& buffer,   // Circular buffer
-        double readDate                // Current read position
+        uint8_t input,                 // Input index
+        uint64_t readPhase,            // Current read position (32.32)
+        uint32_t nbFrames              // Frames elapsed since last adjustment
     );
 
+    // -------------------------------------------------------------------------
+    // Pulls one input block, applies its gain and accumulates into the mix
+    // -------------------------------------------------------------------------
+    void mixChannel(uint8_t input, float* pMix);
+
+    // -------------------------------------------------------------------------
+    // Crossfades the block of an input after a kernel switch (m_BlockIn,
+    // read from readPhase)
+    // -------------------------------------------------------------------------
+    void fadeKernel(uint8_t input, uint64_t readPhase, uint64_t increment);
+
     // =========================================================================
     // Member variables
     // -------------------------------------------------------------------------
 
     // -----------------------------------------------------------------------------
-    // Circular buffers for each input
+    // Circular buffers for each input and their receivers
+    // -----------------------------------------------------------------------------
+    cCircularBuff m_Buffer[NbInputs];
+    const cInputStream* m_pStream[NbInputs];
+
+    // -----------------------------------------------------------------------------
+    // Polyphase sinc coefficient banks (shared by all inputs)
     // -----------------------------------------------------------------------------
-    cCircularBuff BuffIn1;  // Input buffer for channel 1
-    cCircularBuff BuffIn2;  // Input buffer for channel 2
-    cCircularBuff BuffIn3;  // Input buffer for channel 3
+    cPolyphaseSincBank<eSincTaps::Taps16> m_Sinc16;  // 16 taps bank
+    cPolyphaseSincBank<eSincTaps::Taps32> m_Sinc32;  // 32 taps bank
+    cPolyphaseSincBank<eSincTaps::Taps64> m_Sinc64;  // 64 taps bank
 
     // -----------------------------------------------------------------------------
-    // Drift compensation factors (adaptive)
+    // Interpolation kernel cost
     // -----------------------------------------------------------------------------
-    float m_Drif_Factor1;  // Drift factor for input 1
-    float m_Drif_Factor2;  // Drift factor for input 2
-    float m_Drif_Factor3;  // Drift factor for input 3
+    uint32_t m_InterpolationCycles[NB_INTERPOLATIONS];  // CPU cycles per frame and kernel
 
     // -----------------------------------------------------------------------------
-    // Nominal resampling factors (input_rate / 48000)
+    // Block processing buffers
     // -----------------------------------------------------------------------------
-    float m_nominal_factor1;  // Nominal factor for input 1
-    float m_nominal_factor2;  // Nominal factor for input 2
-    float m_nominal_factor3;  // Nominal factor for input 3
+    float m_BlockIn[TX_BUFFER_SIZE];   // Interpolated block of current input
+    float m_BlockFade[TX_BUFFER_SIZE]; // Same block through the kernel faded out
+    float m_BlockMix[TX_BUFFER_SIZE];  // Mix accumulator
 
     // -----------------------------------------------------------------------------
-    // Adaptation parameters
+    // Drift compensation factors (adaptive) and nominal resampling factors
+    // (input_rate / 48000)
     // -----------------------------------------------------------------------------
-    double m_alpha = 0.0000001;  // Low-pass IIR filter coefficient
-    float m_gain = 0.5f;         // Correction gain based on fill level
+    double m_DriftFactor[NbInputs];
+    float m_NominalFactor[NbInputs];
+    double m_FeedForward[NbInputs];      // Last valid measured ratio (loop feed-forward)
 
     // -----------------------------------------------------------------------------
-    // Counters
+    // Drift control loop (PI on the filtered fill error, per input state)
+    // Coefficients are per output frame, index 0 = acquire, 1 = track.
     // -----------------------------------------------------------------------------
-    uint16_t m_ctPull;        // Pull sample counter
-    uint16_t m_ctIN1;         // Input 1 sample counter
-    uint16_t m_ctIN2;         // Input 2 sample counter
-    uint16_t m_ctIN3;         // Input 3 sample counter
+    double m_Kp[2];                      // Proportional gain
+    double m_Ki[2];                      // Integral gain
+    double m_Kf[2];                      // Error pre-filter coefficient
+    double m_Integrator[NbInputs];       // Relative ratio correction (integral part)
+    float m_LoopError[NbInputs];         // Filtered fill error (frames)
+    uint32_t m_LockCount[NbInputs];      // Output frames spent within PLL_LOCK_ERROR
+    eLockState m_LockState[NbInputs];    // Loop state
 
     // -----------------------------------------------------------------------------
-    // Output timestamps
+    // DMA callback / audio task queues and their error counters
     // -----------------------------------------------------------------------------
-    double m_DateOut1;  // Output date for channel 1
-    double m_DateOut2;  // Output date for channel 2
-    double m_DateOut3;  // Output date for channel 3
+    cSPSCQueue<sRxMark, RX_MARK_QUEUE_DEPTH> m_RxMark[NbInputs];  // RX ring half timestamps per input
+    cSPSCQueue<sTxBlock, TX_QUEUE_DEPTH> m_TxQueue;               // Mixed blocks
+    cSPSCQueue<sTxRequest, TX_QUEUE_DEPTH> m_TxRequest;           // TX callback times and input positions
+    sTxBlock m_TxDiscard;                                         // Late block, mixed then dropped
+    uint32_t m_RxOverflow[NbInputs];
+    uint32_t m_TxUnderrun;
+    uint32_t m_TxRequestOverflow;
+    uint32_t m_MixCycles;                                         // Latest mixBlock duration
+    uint32_t m_MixCyclesMax;                                      // Longest mixBlock duration
+    cCpuLoad m_CpuLoad;                                           // Audio interrupts busy cycles, deadlines
+
+    // -----------------------------------------------------------------------------
+    // Level meters (audio task), reset requested by the control side
+    // -----------------------------------------------------------------------------
+    float m_Peak[NbInputs];
+    float m_PeakOut;
+    uint32_t m_ClipCount;
+    std::atomic<uint32_t> m_PeakReset;
+    uint32_t m_PeakResetHandled;
+
+    // -----------------------------------------------------------------------------
+    // Stream rates estimated from the DMA callback timestamps
+    // -----------------------------------------------------------------------------
+    cRateEstimator m_RateIn[NbInputs];  // Input frames vs. cycles (ring halves)
+    cRateEstimator m_RateOut;           // Output frames vs. cycles
+    uint32_t m_OutDate;                 // Output frames produced (wraps at 2^32)
+    uint32_t m_PullTimestamp;           // Timestamp of the current TX callback
+    uint32_t m_MoveTimestamp[NbInputs]; // Last TX callback that saw the input DMA progress
+    bool m_Moving[NbInputs];            // Input DMA progressed within SYNC_TIMEOUT_MS
+    uint32_t m_SyncTimeout;             // SYNC_TIMEOUT_MS in CPU cycles
+    uint32_t m_SourceRate[NbInputs];    // Rate reported by the receivers (Hz, 0 = unknown)
+    uint32_t m_BlockSourceRate[NbInputs]; // m_SourceRate read once for the current block
+
+    // -----------------------------------------------------------------------------
+    // Stream restarts requested by the error callbacks (request counters
+    // written by the callbacks only, handled counts by the audio task only)
+    // -----------------------------------------------------------------------------
+    std::atomic<uint32_t> m_ResyncRequest[NbInputs];  // Receiver restarts
+    uint32_t m_ResyncTimestamp[NbInputs];             // Time of the latest restart
+    uint32_t m_ResyncHandled[NbInputs];               // Requests applied
+    bool m_Resyncing[NbInputs];                       // Waiting for the input to start again
+    uint32_t m_RecoveryCycles[NbInputs];              // Latest restart to first mixed block
+    uint32_t m_RecoveryCyclesMax[NbInputs];           // Longest recovery
+    std::atomic<uint32_t> m_TxRestart;                // TX DMA restarts
+    uint32_t m_TxRestartHandled;                      // TX restarts applied
+
+    // -----------------------------------------------------------------------------
+    // Input starvation and event log (audio task)
+    // -----------------------------------------------------------------------------
+    static_assert((STREAM_EVENT_DEPTH & (STREAM_EVENT_DEPTH - 1)) == 0, "STREAM_EVENT_DEPTH must be a power of two");
+    uint32_t m_UnderrunCount[NbInputs];                 // Underrun events
+    uint32_t m_OverrunCount[NbInputs];                  // Overrun events
+    bool m_Starved[NbInputs];                           // Previous block read out of the ring
+
+    // -----------------------------------------------------------------------------
+    // Kernel switch crossfade (audio task)
+    // -----------------------------------------------------------------------------
+    eInterpolation m_FadeInterp[NbInputs];              // Kernel faded out
+    uint32_t m_FadeFrames[NbInputs];                    // Frames faded (KERNEL_FADE_FRAMES = done)
+    sStreamEvent m_Event[STREAM_EVENT_DEPTH];           // Event n in m_Event[n % STREAM_EVENT_DEPTH]
+    std::atomic<uint32_t> m_EventCount;                 // Events logged
+
+    // -----------------------------------------------------------------------------
+    // Read phases (32.32 fixed point, advanced by the drift factor increment)
+    // -----------------------------------------------------------------------------
+    uint64_t m_ReadPhase[NbInputs];
 
     // -----------------------------------------------------------------------------
     // Detected sample rates
     // -----------------------------------------------------------------------------
-    eSampleRate m_SampleRate1;  // Sample rate for input 1
-    eSampleRate m_SampleRate2;  // Sample rate for input 2
-    eSampleRate m_SampleRate3;  // Sample rate for input 3
+    eSampleRate m_SampleRate[NbInputs];
 
     // -----------------------------------------------------------------------------
-    // Gain controls
+    // User parameters: edited and published by the control side (USB
+    // interrupt), fetched once per block by the audio task, so a block never
+    // mixes with a half updated set
     // -----------------------------------------------------------------------------
-    float m_Gain1;        // Gain for input channel 1
-    float m_Gain2;        // Gain for input channel 2
-    float m_Gain3;        // Gain for input channel 3
-    float m_GainMaster;   // Master output gain
+    struct sMixParams
+    {
+        float Gain[NbInputs];                    // Input gains
+        float GainMaster;                        // Master output gain
+        eInterpolation Interpolation[NbInputs];  // Kernel per input
+    };
+    cParamBlock<sMixParams> m_Params;  // Control side copy and published sets
+    sMixParams m_Active;               // Set used by the current block
+    cParamBlock<sStatus> m_Status;     // Drift state of the latest block (audio path to main loop)
+
+    // -----------------------------------------------------------------------------
+    // Block records for the host replay (audio task)
+    // -----------------------------------------------------------------------------
+    cCapture* m_pCapture;                      // nullptr = no capture
+    bool m_Capturing;                          // Current block recorded
+    bool m_CaptureParams;                      // Next record holds the parameter set
+    uint32_t m_CaptureSourceRate[NbInputs];    // Source rates as replayed
 };
 
+// -----------------------------------------------------------------------------
+// Mixer used by the firmware (instantiated in cMixer.cpp)
+// -----------------------------------------------------------------------------
+using cAudioMixer = cMixer<MIXER_NB_INPUTS>;
+extern template class cMixer<MIXER_NB_INPUTS>;
+
 } // namespace Dad
 
 //***End of file**************************************************************
@@ -0,0 +1,101 @@
+//==================================================================================
+//==================================================================================
+// File: cParamBlock.h
+// Description: Lock-free double buffered parameter block (control side to
+//              real-time side hand-off)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Dad {
+
+//**********************************************************************************
+// cParamBlock
+// The writer edits a private copy of the parameter set and publishes it into
+// one of two slots; the reader copies the last complete slot once per
+// processing block. m_Seq counts two steps per publish (odd while a slot is
+// being written), so the reader knows which slot is complete and whether the
+// writer came back to it during the copy. A copy is only retried when the
+// writer published twice while it was read: the writer never waits and no
+// interrupt masking is needed.
+//
+// One writer context at a time (here the USB interrupt, after the start-up
+// values set from main), one reader context. The mixer status goes the other
+// way: written by the audio path, read by the main loop.
+//**********************************************************************************
+template <typename T>
+class cParamBlock
+{
+public:
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cParamBlock() : m_Edit(), m_Seq(0), m_Fetched(0) {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Writer: parameter set being edited, seen by the reader after Publish
+    // -------------------------------------------------------------------------
+    inline T& Edit() { return m_Edit; }
+    inline const T& getEdit() const { return m_Edit; }
+
+    // -------------------------------------------------------------------------
+    // Writer: copies the edited set into the free slot and publishes it
+    // -------------------------------------------------------------------------
+    inline void Publish()
+    {
+        uint32_t seq = m_Seq.load(std::memory_order_relaxed);  // Even, no write in progress
+        m_Seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);   // Odd count before the slot contents
+        m_Slot[((seq >> 1) + 1) & 1] = m_Edit;
+        m_Seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // -------------------------------------------------------------------------
+    // Reader: copies the last published set into dst if it is newer than the
+    // previous fetch, returns true when dst was updated
+    // -------------------------------------------------------------------------
+    inline bool Fetch(T& dst)
+    {
+        uint32_t seq = m_Seq.load(std::memory_order_acquire);
+        if ((seq >> 1) == m_Fetched) return false;
+
+        for (;;)
+        {
+            uint32_t count = seq >> 1;                          // Complete publishes
+            dst = m_Slot[count & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // The slot is rewritten once m_Seq reaches 2 * count + 3
+            // (second publish after it)
+            uint32_t now = m_Seq.load(std::memory_order_relaxed);
+            if (now - (count << 1) <= 2)
+            {
+                m_Fetched = count;
+                return true;
+            }
+            seq = now;
+        }
+    }
+
+private:
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    T m_Edit;                     // Writer copy
+    T m_Slot[2];                  // Published sets, slot of publish n is n & 1
+    std::atomic<uint32_t> m_Seq;  // 2 x publishes, +1 while a slot is written
+    uint32_t m_Fetched;           // Publish count of the last fetch (reader side)
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
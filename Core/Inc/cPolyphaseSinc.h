@@ -0,0 +1,135 @@
+//==================================================================================
+//==================================================================================
+// File: cPolyphaseSinc.h
+// Description: Polyphase windowed-sinc interpolator with precomputed coefficient
+//              banks (16/32/64 taps) used by cCircularBuff::Pull
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+
+// =============================================================================
+// Configuration constants
+// =============================================================================
+
+#define SINC_NB_PHASES 64             // Number of fractional phases per coefficient bank
+#define SINC_MAX_TAPS 64              // Largest bank, sizes the ring buffer guard region
+#define SINC_CUTOFF 0.90f             // Cutoff frequency (1.0 = input Nyquist)
+
+// -----------------------------------------------------------------------------
+// Estimated cost in CPU cycles per stereo output frame (Cortex-M7 @ 480MHz,
+// single precision FPU, coefficients and samples in zero wait state RAM).
+// Each tap costs 2 sample loads, 2 coefficient loads and 4 FMA (two phases
+// are evaluated and blended), the fixed part covers phase lookup and blend.
+//
+//   Linear  :  ~30 cycles
+//   Sinc 16 : ~100 cycles
+//   Sinc 32 : ~170 cycles
+//   Sinc 64 : ~300 cycles
+//
+// The audio task (PendSV) mixes TX_NB_FRAMES frames per TX callback period,
+// TX_NB_FRAMES / OUTPUT_SAMPLE_RATE, for all inputs, drift control and
+// mixing. The kernels of all inputs must fit in INTERPOLATION_BUDGET_PERCENT
+// of that period, checked against the costs measured at start-up
+// (cMixer::setInterpolation): the period, and the kernels that fit, depend on
+// the audio profile.
+// -----------------------------------------------------------------------------
+
+namespace Dad {
+
+// =============================================================================
+// Enumerations
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+// Available coefficient bank sizes
+// -----------------------------------------------------------------------------
+enum class eSincTaps
+{
+    Taps16 = 16,    // Low cost, ~-60dB stop band
+    Taps32 = 32,    // Balanced quality/cost
+    Taps64 = 64     // High quality, steep transition band
+};
+
+//**********************************************************************************
+// cPolyphaseSinc
+// Kaiser windowed-sinc interpolation kernel evaluated from a bank of
+// SINC_NB_PHASES+1 precomputed phases, with linear blending between the two
+// nearest phases.
+//**********************************************************************************
+class cPolyphaseSinc
+{
+public:
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cPolyphaseSinc() : m_pCoefs(nullptr), m_NbTaps(0) {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Gets number of taps (stereo frames read per output frame)
+    // -------------------------------------------------------------------------
+    inline uint16_t getNbTaps() const { return m_NbTaps; }
+
+    // -------------------------------------------------------------------------
+    // Interpolates one stereo frame from m_NbTaps contiguous interleaved
+    // frames starting at pFrames (oldest). frac is the fractional position
+    // [0, 1[.
+    // -------------------------------------------------------------------------
+    void Interpolate(
+        float* pSamples,              // Output stereo frame
+        const float* pFrames,         // Oldest interleaved frame used
+        float frac                    // Fractional position
+    ) const;
+
+protected:
+    // =========================================================================
+    // Protected methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Computes all phases of the coefficient bank
+    // -------------------------------------------------------------------------
+    void Build(float* pCoefs, uint16_t nbTaps, float cutoff, float beta);
+
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    const float* m_pCoefs;   // Coefficient bank [phase][tap], oldest tap first
+    uint16_t     m_NbTaps;   // Number of taps
+};
+
+//**********************************************************************************
+// cPolyphaseSincBank
+// Coefficient storage for a given tap count
+//**********************************************************************************
+template <eSincTaps Taps>
+class cPolyphaseSincBank : public cPolyphaseSinc
+{
+public:
+    static constexpr uint16_t NB_TAPS = static_cast<uint16_t>(Taps);
+    static_assert(NB_TAPS <= SINC_MAX_TAPS, "SINC_MAX_TAPS too small");
+
+    // -------------------------------------------------------------------------
+    // Computes the coefficient bank (call once at startup)
+    // -------------------------------------------------------------------------
+    void Init(float cutoff = SINC_CUTOFF)
+    {
+        // Kaiser beta grows with tap count to trade transition width for stop band
+        float beta = (NB_TAPS <= 16) ? 6.0f : (NB_TAPS <= 32) ? 7.5f : 9.0f;
+        Build(m_Coefs, NB_TAPS, cutoff, beta);
+    }
+
+private:
+    float m_Coefs[(SINC_NB_PHASES + 1) * NB_TAPS];  // Coefficient storage
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
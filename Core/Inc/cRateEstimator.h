@@ -0,0 +1,107 @@
+//==================================================================================
+//==================================================================================
+// File: cRateEstimator.h
+// Description: Stream rate estimation from callback timestamps (exponentially
+//              weighted linear regression of frame position vs. CPU cycles)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+
+// =============================================================================
+// Configuration constants
+// =============================================================================
+
+#define RATE_EST_WINDOW 1024          // Default regression time constant (callbacks)
+#define RATE_EST_MIN_POINTS 32        // Default callbacks before the estimate is valid
+#define RATE_EST_MAX_ERROR 8.0        // Prediction error restarting the fit (frames)
+
+namespace Dad {
+
+//**********************************************************************************
+// cRateEstimator
+// Fits position = intercept + slope * time over the callback history, older
+// points being weighted by (1 - 1/window)^age. Sums are kept relative
+// to the latest point so they stay small, and time / position differences are
+// computed on wrapping 32-bit counters. A point lying more than
+// RATE_EST_MAX_ERROR frames away from the fit (rate change, lost block)
+// restarts the history from that point.
+//**********************************************************************************
+class cRateEstimator
+{
+public:
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cRateEstimator() { Init(RATE_EST_WINDOW, RATE_EST_MIN_POINTS); }
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Sets the time constant and the valid threshold (callbacks), clears the
+    // history
+    // -------------------------------------------------------------------------
+    void Init(uint32_t window, uint32_t minPoints);
+
+    // -------------------------------------------------------------------------
+    // Clears the history
+    // -------------------------------------------------------------------------
+    void Reset();
+
+    // -------------------------------------------------------------------------
+    // Adds a point: frame position of the stream at a cycle counter timestamp
+    // -------------------------------------------------------------------------
+    void Update(uint32_t timestamp, uint32_t position);
+
+    // -------------------------------------------------------------------------
+    // True once enough points have been collected / no point since reset
+    // -------------------------------------------------------------------------
+    inline bool isValid() const { return m_NbPoints >= m_MinPoints; }
+    inline bool isEmpty() const { return m_NbPoints == 0; }
+
+    // -------------------------------------------------------------------------
+    // Timestamp of the latest point
+    // -------------------------------------------------------------------------
+    inline uint32_t getTimestamp() const { return m_Timestamp; }
+
+    // -------------------------------------------------------------------------
+    // Estimated rate in frames per CPU cycle
+    // -------------------------------------------------------------------------
+    inline double getRate() const { return m_Slope; }
+
+    // -------------------------------------------------------------------------
+    // Estimated (continuous) position at timestamp, relative to position:
+    // returns fitted position - position
+    // -------------------------------------------------------------------------
+    inline double getOffset(uint32_t timestamp, uint32_t position) const
+    {
+        return static_cast<int32_t>(m_Position - position) + m_Intercept +
+               m_Slope * static_cast<int32_t>(timestamp - m_Timestamp);
+    }
+
+private:
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    uint32_t m_Timestamp;    // Latest point time (origin of the sums)
+    uint32_t m_Position;     // Latest point position (origin of the sums)
+    uint32_t m_NbPoints;     // Points received since reset (saturates at m_MinPoints)
+    uint32_t m_MinPoints;    // Points before the estimate is valid
+    double   m_Lambda;       // Forgetting factor
+    double   m_W;            // Sum of weights
+    double   m_Sx;           // Weighted sums relative to the origin
+    double   m_Sy;
+    double   m_Sxx;
+    double   m_Sxy;
+    double   m_Slope;        // Fitted slope (frames per cycle)
+    double   m_Intercept;    // Fitted position at the origin, minus m_Position
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
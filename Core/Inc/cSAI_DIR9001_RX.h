@@ -12,45 +12,81 @@
 #include "main.h"
 #include "cDeviceHandler.h"  // Base class for callback handling
 #include "cMixer.h"
+#include "CycleCounter.h"
+#include "Debug.h"
 #include <cstring>
 
 namespace Dad {
 
+//***************************************************************************
+// DIR9001 pin sets (RESET output, NO_AUDIO / ERROR status inputs)
+//
+// Pin set traits are the template parameter of cSAI_DIR9001_RX: one driver
+// instantiation, with its own callbacks, per receiver.
+struct sDIR9001_Pins1 {
+	static GPIO_TypeDef* ResetPort()   { return RESET1_GPIO_Port; }
+	static GPIO_TypeDef* NoAudioPort() { return NO_AUDIO1_GPIO_Port; }
+	static GPIO_TypeDef* ErrorPort()   { return ERROR1_GPIO_Port; }
+	static constexpr uint16_t ResetPin = RESET1_Pin;
+	static constexpr uint16_t NoAudioPin = NO_AUDIO1_Pin;
+	static constexpr uint16_t ErrorPin = ERROR1_Pin;
+};
+
+struct sDIR9001_Pins2 {
+	static GPIO_TypeDef* ResetPort()   { return RESET2_GPIO_Port; }
+	static GPIO_TypeDef* NoAudioPort() { return NO_AUDIO2_GPIO_Port; }
+	static GPIO_TypeDef* ErrorPort()   { return ERROR2_GPIO_Port; }
+	static constexpr uint16_t ResetPin = RESET2_Pin;
+	static constexpr uint16_t NoAudioPin = NO_AUDIO2_Pin;
+	static constexpr uint16_t ErrorPin = ERROR2_Pin;
+};
+
 //***************************************************************************
 // Class cSAI_DIR9001_RX
 //
 // This class handles the DIR9001 interface in reception mode using the SAI
 // (Serial Audio Interface) of the STM32. It provides initialization,
 // starting and stopping of reception, and callback handling for received data.
-DECLARE_DEVICE_HANDLE(SAI_HandleTypeDef, cSAIA2_Handler, SAIA2)
-class cSAI_DIR9001_RX1 : public cSAIA2_Handler{
+// Pins is the pin set of the receiver (sDIR9001_Pins1, sDIR9001_Pins2).
+template <class Pins>
+class cSAI_DIR9001_RX : public cDeviceHandler<cSAI_DIR9001_RX<Pins>, SAI_HandleTypeDef>, public cInputStream{
+    typedef cDeviceHandler<cSAI_DIR9001_RX<Pins>, SAI_HandleTypeDef> Handler;
+    friend Handler;
+    using Handler::m_phDevice;
+    using Handler::BindRxDMA;
 public:
     //---------------------------------------------------------------------
 	// Constructor / Destructor
-	cSAI_DIR9001_RX1() {}
-	virtual ~cSAI_DIR9001_RX1() {}
+	cSAI_DIR9001_RX() {}
+	virtual ~cSAI_DIR9001_RX() {}
 
     //---------------------------------------------------------------------
 	// Initializes the class and the SAI interface.
-	// It sets up the SAI parameters and registers the necessary callbacks.
-	void Init(SAI_HandleTypeDef* phSAI, cMixer* pMixer, int32_t* pBuffer) {
+	// It sets up the SAI parameters, registers the necessary callbacks and
+	// attaches the ring (CIRCULAR_BUFFER_SAMPLES samples) to the mixer input.
+	void Init(SAI_HandleTypeDef* phSAI, cAudioMixer* pMixer, uint8_t Input, int32_t* pBuffer) {
 		m_pMixer = pMixer;
+		m_Input = Input;
 		m_pBuffer = pBuffer;
 
-		cSAIA2_Handler::Init(phSAI);  // Call base class initialization (register callbacks)
+		Handler::Init(phSAI);         // Call base class initialization (register callbacks)
+		m_pMixer->attachInput(m_Input, m_pBuffer, this);
 
 		// DIR9001 RESET
-		HAL_GPIO_WritePin(RESET1_GPIO_Port, RESET1_Pin, GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(Pins::ResetPort(), Pins::ResetPin, GPIO_PIN_RESET);
 		HAL_Delay(300);
-		HAL_GPIO_WritePin(RESET1_GPIO_Port, RESET1_Pin, GPIO_PIN_SET);
+		HAL_GPIO_WritePin(Pins::ResetPort(), Pins::ResetPin, GPIO_PIN_SET);
 	}
 
     //---------------------------------------------------------------------
 	// Starts receiving data using DMA.
-	// It initiates the DMA transfer to fill the reception buffer.
+	// The circular DMA fills the mixer ring, which reads the write position
+	// from the DMA counter. The half / complete interrupts only timestamp
+	// the ring halves.
 	inline void StartReceive() {
-		std::memset(m_pBuffer, 0xAA, 400);
-		HAL_SAI_Receive_DMA(m_phDevice, (uint8_t *)m_pBuffer, RX_BUFFER_SIZE*2);//, 1000);
+		std::memset(m_pBuffer, 0, CIRCULAR_BUFFER_SAMPLES * sizeof(int32_t));  // Silence
+		HAL_SAI_Receive_DMA(m_phDevice, (uint8_t *)m_pBuffer, CIRCULAR_BUFFER_SAMPLES);
+		BindRxDMA(m_phDevice->hdmarx);      // DMA interrupt -> callbacks below
 	}
 
     //---------------------------------------------------------------------
@@ -60,125 +96,74 @@ public:
 		HAL_SAI_Abort(m_phDevice);
 	}
 
+    //---------------------------------------------------------------------
+	// Restarts the reception after a DMA error (main loop, see Poll: the
+	// HAL aborts wait on HAL_GetTick). The ring is not cleared: the mixer
+	// resynchronizes the input before reading it again.
+	inline void RestartReceive() {
+		HAL_DMA_Abort(m_phDevice->hdmarx);  // Stream left enabled on non TE errors
+		HAL_SAI_Abort(m_phDevice);          // SAI disabled, FIFO flushed
+		HAL_SAI_Receive_DMA(m_phDevice, (uint8_t *)m_pBuffer, CIRCULAR_BUFFER_SAMPLES);
+		BindRxDMA(m_phDevice->hdmarx);
+	}
+
 protected:
     //---------------------------------------------------------------------
     // Datas
 
-    int32_t* m_pBuffer;						 // Buffer for SPDIF data
+    int32_t* m_pBuffer;						 // Mixer input ring (DMA target)
 
-    uint64_t m_CtCallBack = 0;               // Callback counter
-
-    cMixer* m_pMixer = nullptr;              // Pointer to the mixer for audio data
+    cAudioMixer* m_pMixer = nullptr;         // Pointer to the mixer for audio data
+    uint8_t m_Input = 0;                     // Mixer input fed by this receiver
 
     //---------------------------------------------------------------------
-    // Overriding virtual methods from the base class to handle specific
-    // reception callbacks for SAI.
+    // cInputStream: DMA progress and DIR9001 status, read by the mixer at
+    // each TX callback. The input is muted on non PCM data or receive error.
     //
-    virtual void onReceiveComplete_SAIA2() override {
-    	GPIO_PinState NO_AUDIO = HAL_GPIO_ReadPin(NO_AUDIO1_GPIO_Port, NO_AUDIO1_Pin);
-    	GPIO_PinState TRANS_ERR = HAL_GPIO_ReadPin(ERROR1_GPIO_Port, ERROR1_Pin);
-    	if((NO_AUDIO | TRANS_ERR) == 0){
-    		m_pMixer->pushSamples1(&m_pBuffer[RX_BUFFER_SIZE]);
-    	}
-    	m_CtCallBack++;
+    virtual uint32_t getRemaining() const override {
+    	return __HAL_DMA_GET_COUNTER(m_phDevice->hdmarx);
     }
 
-    virtual void onReceiveHalfComplete_SAIA2() override {
-    	GPIO_PinState NO_AUDIO = HAL_GPIO_ReadPin(NO_AUDIO1_GPIO_Port, NO_AUDIO1_Pin);
-    	GPIO_PinState TRANS_ERR = HAL_GPIO_ReadPin(ERROR1_GPIO_Port, ERROR1_Pin);
-    	if((NO_AUDIO | TRANS_ERR) == 0){
-    		m_pMixer->pushSamples1(m_pBuffer);
-    	}
-    	m_CtCallBack++;
+    virtual bool isValid() const override {
+    	GPIO_PinState NO_AUDIO = HAL_GPIO_ReadPin(Pins::NoAudioPort(), Pins::NoAudioPin);
+    	GPIO_PinState TRANS_ERR = HAL_GPIO_ReadPin(Pins::ErrorPort(), Pins::ErrorPin);
+    	return (NO_AUDIO | TRANS_ERR) == 0;
     }
 
-    virtual void onErrorCallback_SAIA2() override {
-        // Error handling logic (can be custom for SPDIF)
-        while (1);  // Infinite loop on error, can be replaced with more graceful error recovery
-    }
-};
-//***************************************************************************
-// Class cSAI_DIR9001_RX2
-//
-// This class handles the DIR9001 interface in reception mode using the SAI
-// (Serial Audio Interface) of the STM32. It provides initialization,
-// starting and stopping of reception, and callback handling for received data.
-DECLARE_DEVICE_HANDLE(SAI_HandleTypeDef, cSAIA3_Handler, SAIA3)
-class cSAI_DIR9001_RX2 : public cSAIA3_Handler{
-public:
-    //---------------------------------------------------------------------
-	// Constructor / Destructor
-	cSAI_DIR9001_RX2() {}
-	virtual ~cSAI_DIR9001_RX2() {}
-
-    //---------------------------------------------------------------------
-	// Initializes the class and the SAI interface.
-	// It sets up the SAI parameters and registers the necessary callbacks.
-	void Init(SAI_HandleTypeDef* phSAI, cMixer* pMixer, int32_t* pBuffer) {
-		m_pMixer = pMixer;
-		m_pBuffer = pBuffer;
-
-		cSAIA3_Handler::Init(phSAI);  // Call base class initialization (register callbacks)
-
-		// DIR9001 RESET
-		HAL_GPIO_WritePin(RESET2_GPIO_Port, RESET2_Pin, GPIO_PIN_RESET);
-		HAL_Delay(300);
-		HAL_GPIO_WritePin(RESET2_GPIO_Port, RESET2_Pin, GPIO_PIN_SET);
-	}
-
-    //---------------------------------------------------------------------
-	// Starts receiving data using DMA.
-	// It initiates the DMA transfer to fill the reception buffer.
-	inline void StartReceive() {
-		std::memset(m_pBuffer, 0xAA, 400);
-		HAL_SAI_Receive_DMA(m_phDevice, (uint8_t *)m_pBuffer, RX_BUFFER_SIZE*2);//, 1000);
-	}
-
     //---------------------------------------------------------------------
-	// Stops the reception of data.
-	// It aborts the ongoing DMA transfer, halting any data reception.
-	inline void StopReceive() {
-		HAL_SAI_Abort(m_phDevice);
-	}
-
-protected:
-    //---------------------------------------------------------------------
-    // Datas
-
-    int32_t* m_pBuffer;						 // Buffer for SPDIF data
-
-    uint64_t m_CtCallBack = 0;               // Callback counter
-
-    cMixer* m_pMixer = nullptr;              // Pointer to the mixer for audio data
-
-    //---------------------------------------------------------------------
-    // Overriding virtual methods from the base class to handle specific
-    // reception callbacks for SAI.
+    // Callbacks called by the base class (static dispatch) to handle
+    // specific reception callbacks for SAI.
     //
-    virtual void onReceiveComplete_SAIA3() override {
-    	GPIO_PinState NO_AUDIO = HAL_GPIO_ReadPin(NO_AUDIO2_GPIO_Port, NO_AUDIO2_Pin);
-    	GPIO_PinState TRANS_ERR = HAL_GPIO_ReadPin(ERROR2_GPIO_Port, ERROR2_Pin);
-    	if((NO_AUDIO | TRANS_ERR) == 0){
-    		m_pMixer->pushSamples3(&m_pBuffer[RX_BUFFER_SIZE]);
-    	}
-    	m_CtCallBack++;
+    ITCM_CODE void onReceiveComplete() {
+    	uint32_t Timestamp = CycleCounterGet();
+    	m_pMixer->markInput(m_Input, 0, Timestamp);  // Ring wrapped
+    	PROFILE_STOP(Timestamp, PROBE_RX_DMA + m_Input);
+    }
+
+    ITCM_CODE void onReceiveHalfComplete() {
+    	uint32_t Timestamp = CycleCounterGet();
+    	m_pMixer->markInput(m_Input, RX_MARK_FRAMES, Timestamp);
+    	PROFILE_STOP(Timestamp, PROBE_RX_DMA + m_Input);
     }
 
-    virtual void onReceiveHalfComplete_SAIA3() override {
-    	GPIO_PinState NO_AUDIO = HAL_GPIO_ReadPin(NO_AUDIO2_GPIO_Port, NO_AUDIO2_Pin);
-    	GPIO_PinState TRANS_ERR = HAL_GPIO_ReadPin(ERROR2_GPIO_Port, ERROR2_Pin);
-    	if((NO_AUDIO | TRANS_ERR) == 0){
-    		m_pMixer->pushSamples3(m_pBuffer);
-    	}
-    	m_CtCallBack++;
+    void onDeviceError() {
+        // Restarts this receiver only: the mixer mutes and resynchronizes
+        // its input, the other inputs and the output keep running. The DMA
+        // is restarted by the main loop.
+        m_pMixer->resyncInput(m_Input, CycleCounterGet());
+        Handler::requestRestart();
     }
 
-    virtual void onErrorCallback_SAIA3() override {
-        // Error handling logic (can be custom for SPDIF)
-        while (1);  // Infinite loop on error, can be replaced with more graceful error recovery
+    void onRestart() {
+        RestartReceive();
     }
 };
 
+//***************************************************************************
+// DIR9001 receivers of the board
+typedef cSAI_DIR9001_RX<sDIR9001_Pins1> cSAI_DIR9001_RX1;
+typedef cSAI_DIR9001_RX<sDIR9001_Pins2> cSAI_DIR9001_RX2;
+
 } /* namespace Dad */
 
 #endif /* CSAIWM8805RX_H_ */
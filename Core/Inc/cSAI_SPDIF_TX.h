@@ -2,7 +2,7 @@
 // cSAI_SPDIF_TX.h
 //
 // This file defines a class to handle SPDIF transmission using the SAI
-// interface, inheriting from `cSAI_Handler` to manage callbacks more easily.
+// interface, inheriting from `cDeviceHandler` to manage callbacks more easily.
 //******************************************************************************
 
 #ifndef CSAISPDIFTX_H_
@@ -11,14 +11,18 @@
 #include "main.h"
 #include "cDeviceHandler.h"  // Base class for callback handling
 #include "cMixer.h"
+#include "CycleCounter.h"
+#include "AudioTask.h"
+#include "Debug.h"
+#include <cstring>
 namespace Dad {
 //***************************************************************************
 // Class cSAI_SPDIF_TX
 // Transmission of an SPDIF audio stream using SAI.
-// This class inherits from `cSAI_Handler` for callback-based SAI handling.
+// This class inherits from `cDeviceHandler` for callback-based SAI handling.
 //
-DECLARE_DEVICE_HANDLE(SAI_HandleTypeDef, cSAIA1_Handler, SAIA1);
-class cSAI_SPDIF_TX : public cSAIA1_Handler {
+class cSAI_SPDIF_TX : public cDeviceHandler<cSAI_SPDIF_TX, SAI_HandleTypeDef> {
+    friend class cDeviceHandler<cSAI_SPDIF_TX, SAI_HandleTypeDef>;
 public:
     //---------------------------------------------------------------------
     // Constructor / Destructor
@@ -27,10 +31,13 @@ public:
 
     //---------------------------------------------------------------------
     // Initialization: Sets up the mixer and prepares the SAI for SPDIF transmission.
+    // pBuffer is the DMA double buffer (TX_BUFFER_SIZE * 2 samples, DMA_BUFFER).
     //
-    void Init(SAI_HandleTypeDef* phSAI, cMixer* pMixer) {
+    void Init(SAI_HandleTypeDef* phSAI, cAudioMixer* pMixer, int32_t* pBuffer) {
 		m_pMixer = pMixer;                   // Store the mixer instance
-		cSAIA1_Handler::Init(phSAI);         // Call base class initialization (register callbacks)
+		m_pBuffer = pBuffer;
+		std::memset(m_pBuffer, 0, TX_BUFFER_SIZE * 2 * sizeof(int32_t));  // Silence
+		cDeviceHandler::Init(phSAI);         // Call base class initialization (register callbacks)
 	}
 
     //---------------------------------------------------------------------
@@ -39,7 +46,8 @@ public:
     //
     inline void StartTransmit() {
         // Start the DMA transmission
-        HAL_SAI_Transmit_DMA(m_phDevice, (uint8_t*)m_Buffer, TX_BUFFER_SIZE * 2);
+        HAL_SAI_Transmit_DMA(m_phDevice, (uint8_t*)m_pBuffer, TX_BUFFER_SIZE * 2);
+        BindTxDMA(m_phDevice->hdmatx);      // DMA interrupt -> callbacks below
     }
 
     //---------------------------------------------------------------------
@@ -49,33 +57,56 @@ public:
            HAL_SAI_Abort(m_phDevice);
     }
 
+    //---------------------------------------------------------------------
+    // Restarts the transmission after a DMA error (main loop, see Poll: the
+    // HAL aborts and the FIFO wait of the start count HAL_GetTick).
+    //
+    inline void RestartTransmit() {
+        HAL_DMA_Abort(m_phDevice->hdmatx);  // Stream left enabled on non TE errors
+        HAL_SAI_Abort(m_phDevice);          // SAI disabled, FIFO flushed
+        HAL_SAI_Transmit_DMA(m_phDevice, (uint8_t*)m_pBuffer, TX_BUFFER_SIZE * 2);
+        BindTxDMA(m_phDevice->hdmatx);
+    }
+
 protected:
     //---------------------------------------------------------------------
     // Datas
 
-    int32_t              m_Buffer[TX_BUFFER_SIZE * 2]; // Buffer for SPDIF data
+    int32_t*             m_pBuffer = nullptr;        // DMA double buffer for SPDIF data
 
     uint64_t             m_CtCallBack=0;              // Callback counter
 
-    cMixer*              m_pMixer = nullptr;         // Pointer to the mixer for audio data
+    cAudioMixer*         m_pMixer = nullptr;         // Pointer to the mixer for audio data
 
     //---------------------------------------------------------------------
-    // Overriding virtual methods from the base class to handle specific
-    // transmission callbacks for SAI SPDIF.
+    // Callbacks called by the base class (static dispatch) to handle
+    // specific transmission callbacks for SAI SPDIF.
     //
-    virtual void onTransmitComplete_SAIA1() override {
-    	m_pMixer->pullSamples(&m_Buffer[TX_BUFFER_SIZE]);
+    ITCM_CODE void onTransmitComplete() {
+    	uint32_t Timestamp = CycleCounterGet();  // DMA completion time
+    	m_pMixer->fetchSamples(&m_pBuffer[TX_BUFFER_SIZE], Timestamp);
+    	AudioTaskTrigger();                      // Mix the next block
     	m_CtCallBack++;
+    	PROFILE_STOP(Timestamp, PROBE_TX_DMA);
     }
 
-    virtual void onTransmitHalfComplete_SAIA1() override {
-    	m_pMixer->pullSamples(m_Buffer);
+    ITCM_CODE void onTransmitHalfComplete() {
+    	uint32_t Timestamp = CycleCounterGet();  // DMA completion time
+    	m_pMixer->fetchSamples(m_pBuffer, Timestamp);
+    	AudioTaskTrigger();                      // Mix the next block
     	m_CtCallBack++;
+    	PROFILE_STOP(Timestamp, PROBE_TX_DMA);
+    }
+
+    void onDeviceError() {
+        // Restarts the output from the main loop: the queued blocks are kept
+        // and the mixer restarts its output rate estimate
+        m_pMixer->restartOutput();
+        requestRestart();
     }
 
-    virtual void onErrorCallback_SAIA1() override {
-        // Error handling logic (can be custom for SPDIF)
-        while (1); // Infinite loop on error, can be replaced with more graceful error recovery
+    void onRestart() {
+        RestartTransmit();
     }
 };
 } /* namespace Dad */
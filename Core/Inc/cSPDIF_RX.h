@@ -5,15 +5,15 @@
 // reception of audio data from an S/PDIF (Sony/Philips Digital Interface) stream.
 //
 // The class inherits from two handlers:
-// - `cSPDIFRX_Handler` to handle interrupts related to audio data reception
+// - `cDeviceRxHandler` to handle interrupts related to audio data reception
 //   via DMA.
 // - `cTIM_Handler` to manage periodic timer interrupts, used to monitor
 //   synchronization and ensure the proper handling of the audio stream.
 //
-// The class allows for initialization, processing DMA callbacks for complete
-// and half-complete data reception, and calculating the sample rate of the
-// incoming audio stream. It also provides utility methods to access the current
-// sample rate and synchronization state.
+// The class allows for initialization, reception by circular DMA into the
+// mixer input ring (DMA callbacks only timestamp the ring halves), and
+// calculating the sample rate of the incoming audio stream. It also provides
+// utility methods to access the current sample rate and synchronization state.
 //
 //***************************************************************************
 
@@ -24,6 +24,8 @@
 #include "cDeviceHandler.h"  // Base class for callback handling
 #include "cTIM_Handler.h"
 #include "cMixer.h"
+#include "CycleCounter.h"
+#include "Debug.h"
 
 namespace Dad {
 
@@ -48,11 +50,11 @@ enum class eEtatSPDif {
 // Class cSPDIF_RX
 //
 // This class manages the reception of an S/PDIF stream by inheriting from
-// `cSPDIFRX_Handler` for handling S/PDIF DMA-related callbacks, and from
+// `cDeviceRxHandler` for handling S/PDIF DMA-related callbacks, and from
 // `cTIM_Handler` for managing timer interrupts.
 //
-DECLARE_DEVICE_RXHANDLE(SPDIFRX_HandleTypeDef, cSPDIFRX_Handler, SPDIF_RX);
-class cSPDIF_RX : public cSPDIFRX_Handler, cTIM_Handler {
+class cSPDIF_RX : public cDeviceRxHandler<cSPDIF_RX, SPDIFRX_HandleTypeDef>, cTIM_Handler, public cInputStream {
+    friend cDeviceRxHandler<cSPDIF_RX, SPDIFRX_HandleTypeDef>;
 public:
 
 
@@ -70,28 +72,56 @@ public:
     // Initializes the S/PDIF reception system based on the provided clock
     // frequency (Freq_SPDiff_Clk).
     //
+    // @param Input: Mixer input fed by this receiver
+    // @param pBuffer: Mixer input ring (CIRCULAR_BUFFER_SAMPLES samples)
     // @param Freq_SPDiff_Clk: Clock frequency for calculate samplerate
     //
-    void Init(SPDIFRX_HandleTypeDef* phSPDIFRX, TIM_HandleTypeDef* phTIM, cMixer* pMixer, uint32_t Freq_SPDiff_Clk);
+    void Init(SPDIFRX_HandleTypeDef* phSPDIFRX, TIM_HandleTypeDef* phTIM, cAudioMixer* pMixer, uint8_t Input, int32_t* pBuffer, uint32_t Freq_SPDiff_Clk);
 
     //---------------------------------------------------------------------
-    // DMA Callback - onReceiveComplete
+    // cInputStream - getRemaining / isValid
     //
-    // Called when the complete buffer is received via DMA.
+    // DMA progress in the mixer ring, read by the mixer at each TX callback.
+    // The input is valid while the state machine monitors a synchronized
+    // stream.
     //
-    virtual void onReceiveComplete_SPDIF_RX() override {
-       m_pMixer->pushSamples2(&m_Buffer[RX_BUFFER_SIZE]);
-        m_CtCallBack++;  // Increment callback counter
+    virtual uint32_t getRemaining() const override {
+        return __HAL_DMA_GET_COUNTER(m_phDevice->hdmaDrRx);
+    }
+
+    virtual bool isValid() const override {
+        return m_EtatSPDif == eEtatSPDif::run;
+    }
+
+    //---------------------------------------------------------------------
+    // DMA Callbacks - onReceiveComplete / onReceiveHalfComplete
+    //
+    // Timestamp of each ring half for the mixer rate estimate.
+    //
+    ITCM_CODE void onReceiveComplete() {
+        uint32_t Timestamp = CycleCounterGet();
+        m_pMixer->markInput(m_Input, 0, Timestamp);  // Ring wrapped
+        PROFILE_STOP(Timestamp, PROBE_RX_DMA + m_Input);
+    }
+
+    ITCM_CODE void onReceiveHalfComplete() {
+        uint32_t Timestamp = CycleCounterGet();
+        m_pMixer->markInput(m_Input, RX_MARK_FRAMES, Timestamp);
+        PROFILE_STOP(Timestamp, PROBE_RX_DMA + m_Input);
     }
 
     //---------------------------------------------------------------------
-    // DMA Callback - onReceiveHalfComplete
+    // DMA Callback - onDeviceError
     //
-    // Called when half of the buffer is filled via DMA.
+    // The HAL stopped the DMA requests: the state machine restarts the
+    // receiver at its next period, the mixer resynchronizes the input.
+    // The timer interrupt runs above SysTick too: the state machine only
+    // uses HAL_DMA_Abort_IT and the SPDIFRX start, whose waits are bounded
+    // loop counts (no HAL_GetTick timeout), see cDeviceHandler.
     //
-    virtual void onReceiveHalfComplete_SPDIF_RX() override {
-    	m_pMixer->pushSamples2(m_Buffer);
-        m_CtCallBack++;  // Increment callback counter
+    void onDeviceError() {
+        m_pMixer->resyncInput(m_Input, CycleCounterGet());
+        m_EtatSPDif = eEtatSPDif::init;
     }
 
     //---------------------------------------------------------------------
@@ -137,15 +167,14 @@ protected:
 
     //---------------------------------------------------------------------
     // Member Variables
-    cMixer*		m_pMixer;
-	eEtatSPDif	m_EtatSPDif;            		// Synchronization state of the S/PDIF
+    cAudioMixer* m_pMixer;
+    uint8_t     m_Input;                		// Mixer input fed by this receiver
+	volatile eEtatSPDif m_EtatSPDif;        		// Synchronization state of the S/PDIF
 
 	uint32_t    m_Freq_SPDiff_Clk;      		// Clock frequency for calculate S/PDIF samplerate
 	uint32_t    m_SPDiff_SampleRate;    		// Sample rate of the received stream
 
-	int32_t     m_Buffer[RX_BUFFER_SIZE * 2]; 	// Double buffer for S/PDIF reception
-
-	uint64_t    m_CtCallBack;           		// Counter to track the number of callbacks
+	int32_t*    m_pBuffer;              		// Mixer input ring (DMA target)
 
 };
 
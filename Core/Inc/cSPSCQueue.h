@@ -0,0 +1,99 @@
+//==================================================================================
+//==================================================================================
+// File: cSPSCQueue.h
+// Description: Lock-free single producer / single consumer queue of fixed size
+//              elements (interrupt to task hand-off)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Dad {
+
+//**********************************************************************************
+// cSPSCQueue
+// Ring of Size slots (power of two) indexed by free running head / tail
+// counters. Only the producer writes m_Head and only the consumer writes
+// m_Tail, the release / acquire pair orders the slot contents with the index
+// update, so no interrupt masking is needed. Slots are filled and read in
+// place (Reserve / Commit, Front / Release) to avoid an extra copy.
+//**********************************************************************************
+template <typename T, uint32_t Size>
+class cSPSCQueue
+{
+public:
+    static_assert((Size & (Size - 1)) == 0, "cSPSCQueue size must be a power of two");
+
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cSPSCQueue() : m_Head(0), m_Tail(0) {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Empties the queue (producer and consumer must both be idle)
+    // -------------------------------------------------------------------------
+    inline void Clear()
+    {
+        m_Head.store(0, std::memory_order_relaxed);
+        m_Tail.store(0, std::memory_order_relaxed);
+    }
+
+    // -------------------------------------------------------------------------
+    // Number of queued elements (exact on either side, a lower bound of the
+    // free / used space seen by the other side)
+    // -------------------------------------------------------------------------
+    inline uint32_t getCount() const
+    {
+        return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+    }
+
+    // -------------------------------------------------------------------------
+    // Producer: next free slot (nullptr if full), then Commit to publish it
+    // -------------------------------------------------------------------------
+    inline T* Reserve()
+    {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_Tail.load(std::memory_order_acquire) >= Size) return nullptr;
+        return &m_Slots[head & (Size - 1)];
+    }
+
+    inline void Commit()
+    {
+        m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer: oldest element (nullptr if empty), then Release to free it
+    // -------------------------------------------------------------------------
+    inline const T* Front() const
+    {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (m_Head.load(std::memory_order_acquire) == tail) return nullptr;
+        return &m_Slots[tail & (Size - 1)];
+    }
+
+    inline void Release()
+    {
+        m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    T m_Slots[Size];                    // Element storage
+    std::atomic<uint32_t> m_Head;       // Elements produced (producer side)
+    std::atomic<uint32_t> m_Tail;       // Elements consumed (consumer side)
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -0,0 +1,128 @@
+//==================================================================================
+//==================================================================================
+// File: cTelemetry.h
+// Description: Mixer telemetry frames over USB MIDI SysEx (main loop)
+//
+// Frame (each value in 5 bytes of 7 bits, least significant first, signed
+// values as two's complement):
+//   F0 SYSEX_ID SYSEX_TELEMETRY <version> <inputs>
+//   <sequence> <TX underruns> <TX request overflows> <TX restarts>
+//   <CPU load> <CPU load average> <CPU load peak> <deadline misses>
+//   <deadline use> <output peak> <clips>
+//   per input:
+//   <lock state> <sample rate> <measured rate> <drift factor> <fill level>
+//   <loop error> <RX overflows> <resyncs> <peak> <underruns> <overruns>
+//   F7
+//
+//   sequence      Frame counter (gaps = frames not sent, USB busy)
+//   TX request    TX requests dropped, request queue full (blocks never
+//   overflows     mixed, see cMixer::getTxRequestOverflowCount)
+//   CPU load      Audio interrupts busy time, per mille of the CPU: latest
+//                 window, last second, highest window since the previous
+//                 frame (cCpuLoad.h)
+//   deadline      Blocks mixed after the next TX callback was due since
+//                 start-up / latest block finish since the previous frame,
+//                 per mille of the TX period
+//   peak          Q8.24, 1.0 = full scale, since the previous frame
+//   clips         Output blocks clipped since start-up
+//   lock state    eLockState (0 NoSync, 1 Acquire, 2 Track)
+//   sample rate   Standard rate detected (Hz, 0 = no sync)
+//   measured rate Input rate from the callback timestamps (mHz, output clock)
+//   drift factor  Input frames per output frame (Q4.28)
+//   fill level    Read position age (Q24.8 frames)
+//   loop error    Filtered fill error of the drift loop (Q24.8 frames, signed)
+//   underruns     Underrun / overrun events of the input (runs of blocks read
+//   overruns      out of the ring, see cMixer::getUnderrunCount)
+//
+// Each new stream event of the mixer log is sent once, between the frames:
+//   F0 SYSEX_ID SYSEX_EVENT <version> <input> <type> <lock state>
+//   <index> <timestamp> <output date> <fill level> <loop error>
+//   <drift factor> <frames> F7
+//
+//   type          eStreamEvent (0 Underrun, 1 Overrun, 2 Resync)
+//   index         Event number (gaps = events overwritten before being sent)
+//   timestamp     CPU cycles (DWT) of the detection, or of the error callback
+//   output date   Output frames produced before the event
+//   fill level, loop error, drift factor as in the frame, at the event
+//   frames        Frames returned as silence in the block
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#pragma once
+
+#include "main.h"
+#include "cMixer.h"
+
+namespace Dad {
+
+//**********************************************************************************
+// cTelemetry
+// Builds a frame from the mixer getters and sends it without waiting: a frame
+// is dropped when the previous USB transfer is not complete. Runs from the
+// main loop only, the audio path is never waited for.
+//**********************************************************************************
+class cTelemetry
+{
+public:
+    static constexpr uint8_t VERSION = 4;
+
+    // =========================================================================
+    // Constructor
+    // -------------------------------------------------------------------------
+    cTelemetry() : m_pMixer(nullptr), m_Period(0), m_LastSend(0), m_Sequence(0), m_Dropped(0), m_EventRead(0), m_Status() {}
+
+    // =========================================================================
+    // Public methods
+    // -------------------------------------------------------------------------
+
+    // -------------------------------------------------------------------------
+    // Initializes with the start-up rate (frames per second, 0 = off)
+    // -------------------------------------------------------------------------
+    void Init(cAudioMixer* pMixer, uint8_t rate);
+
+    // -------------------------------------------------------------------------
+    // Frames per second (0 = off, clamped to TELEMETRY_MAX_RATE), from any
+    // context (CC_TELEMETRY in the USB interrupt)
+    // -------------------------------------------------------------------------
+    void setRate(uint8_t rate);
+
+    // -------------------------------------------------------------------------
+    // Main loop: sends a frame when its period elapsed (now in ms), else the
+    // next stream event not sent yet
+    // -------------------------------------------------------------------------
+    void Poll(uint32_t now);
+
+    // -------------------------------------------------------------------------
+    // Frames not sent (USB busy or not connected)
+    // -------------------------------------------------------------------------
+    uint32_t getDroppedCount() const { return m_Dropped; }
+
+private:
+    // Header, 11 global values, 11 values per input, F7
+    static constexpr uint16_t FRAME_SIZE = 5 + (11 + 11 * cAudioMixer::NB_INPUTS) * 5 + 1;
+
+    // Header, 7 values, F7
+    static constexpr uint16_t EVENT_SIZE = 7 + 7 * 5 + 1;
+
+    // =========================================================================
+    // Private methods
+    // -------------------------------------------------------------------------
+    uint16_t buildFrame(uint8_t* pFrame);
+    void sendEvent();
+
+    // =========================================================================
+    // Member variables
+    // -------------------------------------------------------------------------
+    cAudioMixer* m_pMixer;
+    volatile uint32_t m_Period;     // ms between frames (0 = off)
+    uint32_t m_LastSend;            // Time of the last frame (ms)
+    uint32_t m_Sequence;            // Frames built
+    uint32_t m_Dropped;             // Frames not sent
+    uint32_t m_EventRead;           // Next mixer event to send
+    cAudioMixer::sStatus m_Status;  // Drift state of the latest mixed block
+};
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -46,7 +46,14 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
-
+// Memory placement (see MPU_Config and the linker script). Both data
+// sections are NOLOAD and not cleared by the startup code: buffers are cleared
+// before use, objects are set by their constructor.
+#define DMA_BUFFER __attribute__((section(".RAM_D2_Section"), aligned(32)))  // D2 SRAM, non-cacheable
+#define DTCM_DATA  __attribute__((section(".DTCMRAM_Section"), aligned(8)))  // DTCM, CPU only (no DMA1/2 access)
+// Real-time code: linked in ITCM, copied from flash by the startup code
+// (zero wait state, no I-cache miss or eviction by the control code)
+#define ITCM_CODE  __attribute__((section(".itcm_text")))
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
@@ -87,6 +94,21 @@ void Error_Handler(void);
 #define CC_GAIN_2 20
 #define CC_GAIN_3 22
 #define CC_GAIN_MASTER 23
+#define CC_INTERP_1 24
+#define CC_INTERP_2 25
+#define CC_INTERP_3 26
+#define CC_PROFILE 27         // Profiling probes dump (0-126) / clear (127), debug builds
+#define SYSEX_ID 0x7D        // SysEx manufacturer ID (non-commercial)
+#define SYSEX_PROFILE 0x01   // SysEx message: profiling probe
+#define CC_TELEMETRY 28       // Telemetry frames per second (0 = off, max TELEMETRY_MAX_RATE)
+#define SYSEX_TELEMETRY 0x02 // SysEx message: telemetry frame
+#define SYSEX_EVENT 0x03     // SysEx message: stream event (underrun, overrun, resync)
+#define CC_CAPTURE 29         // Input capture stop (0) / dump (1-126) / clear (127), CAPTURE_ENABLE builds
+#define SYSEX_CAPTURE 0x04   // SysEx message: input capture dump
+#define INPUT_RX1 0          // Mixer input of DIR9001 receiver 1 (SAI2)
+#define INPUT_SPDIFRX 1      // Mixer input of SPDIFRX
+#define INPUT_RX2 2          // Mixer input of DIR9001 receiver 2 (SAI3)
+#define MIXER_NB_INPUTS 3    // Mixer inputs, one per receiver (sizes the mixer and the RX probes)
 #define MIDI_CANAL 1
 #define FLASH_ADR 0x90000000
 
@@ -0,0 +1,116 @@
+//==================================================================================
+//==================================================================================
+// File: Debug.cpp
+// Description: Cycle profiling probes storage and USB MIDI dump (debug builds)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "Debug.h"
+
+#ifdef DEBUG
+
+#include "usbd_midi_if.h"
+#include <cstring>
+
+// =============================================================================
+// Probes, in DTCM with the other real-time data (not initialized at reset:
+// cleared by Profile_Reset)
+// -----------------------------------------------------------------------------
+DTCM_DATA sProfileProbe ProfileProbes[NB_PROBES];
+
+// Request from the USB interrupt to the main loop
+static volatile uint8_t __ProfileDump = 0;
+static volatile uint8_t __ProfileClear = 0;
+
+constexpr uint32_t PROFILE_SEND_TIMEOUT = 10;  // ms, previous USB transfer
+
+// -----------------------------------------------------------------------------
+// Clears all probes
+// -----------------------------------------------------------------------------
+void Profile_Reset(void)
+{
+    std::memset(ProfileProbes, 0, sizeof(ProfileProbes));
+}
+
+// -----------------------------------------------------------------------------
+// CC_PROFILE received (USB interrupt): handled by the next Profile_Poll
+// -----------------------------------------------------------------------------
+void Profile_Request(uint8_t Value)
+{
+    if (Value == 127)
+    {
+        __ProfileClear = 1;
+    }
+    else
+    {
+        __ProfileDump = 1;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Copies a probe written by an interrupt (main loop)
+// The writers preempt the main loop and complete their record before it
+// resumes: the copy is coherent when Count did not change while it was made.
+// -----------------------------------------------------------------------------
+static void Profile_Snapshot(uint32_t Probe, sProfileProbe& Copy)
+{
+    const volatile sProfileProbe* pProbe = &ProfileProbes[Probe];
+    uint32_t Count;
+    do
+    {
+        Count = pProbe->Count;
+        std::memcpy(&Copy, const_cast<const sProfileProbe*>(pProbe), sizeof(Copy));
+        __DMB();
+    } while (Count != pProbe->Count || Count != Copy.Count);
+}
+
+// -----------------------------------------------------------------------------
+// Main loop: clears the probes or sends them, one SysEx per probe
+// -----------------------------------------------------------------------------
+void Profile_Poll(void)
+{
+    if (__ProfileClear)
+    {
+        __ProfileClear = 0;
+        Profile_Reset();
+    }
+    if (!__ProfileDump) return;
+    __ProfileDump = 0;
+
+    uint8_t Msg[5 + (4 + PROFILE_NB_BINS) * 5 + 1];
+    for (uint32_t Probe = 0; Probe < NB_PROBES; Probe++)
+    {
+        sProfileProbe Copy;
+        Profile_Snapshot(Probe, Copy);
+
+        uint8_t* pDst = Msg;
+        *pDst++ = 0xF0;
+        *pDst++ = SYSEX_ID;
+        *pDst++ = SYSEX_PROFILE;
+        *pDst++ = static_cast<uint8_t>(Probe);
+        *pDst++ = PROFILE_NB_BINS;
+        pDst = MIDI_SysExPut32(pDst, Copy.Count);
+        pDst = MIDI_SysExPut32(pDst, Copy.Min);
+        pDst = MIDI_SysExPut32(pDst, Copy.Max);
+        pDst = MIDI_SysExPut32(pDst, (Copy.Count != 0) ? static_cast<uint32_t>(Copy.Sum / Copy.Count) : 0);
+        for (uint32_t Bin = 0; Bin < PROFILE_NB_BINS; Bin++)
+        {
+            pDst = MIDI_SysExPut32(pDst, Copy.Histogram[Bin]);
+        }
+        *pDst++ = 0xF7;
+
+        // Waits for the previous probe transfer (main loop only)
+        uint32_t Start = HAL_GetTick();
+        uint8_t Result;
+        while ((Result = MIDI_SendSysEx(Msg, pDst - Msg)) == USBD_BUSY)
+        {
+            if ((HAL_GetTick() - Start) > PROFILE_SEND_TIMEOUT) break;
+        }
+        if (Result != USBD_OK) return;   // Host not reading, dump dropped
+    }
+}
+
+#endif
+
+//***End of file**************************************************************
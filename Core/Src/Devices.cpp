@@ -1,19 +0,0 @@
-//******************************************************************************
-// Devices
-//
-#include "cSAI_DIR9001_RX.h"
-#include "cSAI_SPDIF_TX.h"
-#include "cSPDIF_RX.h"
-
-namespace Dad {
-INSTANTIATE_DEVICE_HANDLE(cSAIA1_Handler);
-INSTANTIATE_DEVICE_HANDLE(cSAIA2_Handler);
-INSTANTIATE_DEVICE_HANDLE(cSAIA3_Handler);
-INSTANTIATE_DEVICE_RXHANDLE(cSPDIFRX_Handler);
-}
-
-
-
-
-
-
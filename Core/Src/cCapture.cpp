@@ -0,0 +1,122 @@
+//==================================================================================
+//==================================================================================
+// File: cCapture.cpp
+// Description: Record ring of the mixer inputs for deterministic host replay
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cCapture.h"
+#include <algorithm>
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Sets the ring storage and the recorded inputs
+// -----------------------------------------------------------------------------
+void cCapture::Init(uint8_t* pRing, uint32_t size, uint8_t sampleMask)
+{
+    m_pRing = pRing;
+    m_Mask = size - 1;
+    m_SampleMask = sampleMask;
+    m_Write = 0;
+    m_Free = 0;
+    m_Head.store(0, std::memory_order_relaxed);
+    m_Tail.store(0, std::memory_order_relaxed);
+    m_StopRequest.store(false, std::memory_order_relaxed);
+    m_State.store(eState::Idle, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Starts recording (ring attached, writer not running yet)
+// -----------------------------------------------------------------------------
+void cCapture::Start()
+{
+    if ((m_pRing == nullptr) || (getState() != eState::Idle)) return;
+    m_State.store(eState::Recording, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Opens a record at the published end, with the room left by the reader
+// -----------------------------------------------------------------------------
+bool cCapture::BeginRecord()
+{
+    if (getState() != eState::Recording) return false;
+    if (m_StopRequest.load(std::memory_order_acquire))
+    {
+        m_State.store(eState::Stopped, std::memory_order_release);
+        return false;
+    }
+
+    uint32_t head = m_Head.load(std::memory_order_relaxed);
+    m_Write = head;
+    m_Free = (m_Mask + 1) - (head - m_Tail.load(std::memory_order_acquire));
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Publishes the record, or stops the capture when it did not fit
+// -----------------------------------------------------------------------------
+void cCapture::EndRecord()
+{
+    if (m_Free == OVERFLOW)
+    {
+        m_State.store(eState::Overflow, std::memory_order_release);
+        return;
+    }
+    m_Head.store(m_Write, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Appends samples as 3 bytes each (low 24 bits, sign extended on replay)
+// -----------------------------------------------------------------------------
+void cCapture::PutSamples24(const int32_t* pSamples, uint32_t nbSamples)
+{
+    if ((m_Free == OVERFLOW) || (m_Free < nbSamples * 3))
+    {
+        m_Free = OVERFLOW;
+        return;
+    }
+    for (uint32_t i = 0; i < nbSamples; i++)
+    {
+        uint32_t value = static_cast<uint32_t>(pSamples[i]);
+        m_pRing[m_Write++ & m_Mask] = static_cast<uint8_t>(value);
+        m_pRing[m_Write++ & m_Mask] = static_cast<uint8_t>(value >> 8);
+        m_pRing[m_Write++ & m_Mask] = static_cast<uint8_t>(value >> 16);
+    }
+    m_Free -= nbSamples * 3;
+}
+
+// -----------------------------------------------------------------------------
+// Copies and releases published bytes (reader)
+// -----------------------------------------------------------------------------
+uint32_t cCapture::Read(uint8_t* pDst, uint32_t size)
+{
+    uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+    uint32_t count = std::min(size, m_Head.load(std::memory_order_acquire) - tail);
+
+    uint32_t index = tail & m_Mask;
+    uint32_t first = std::min(count, m_Mask + 1 - index);
+    std::memcpy(pDst, &m_pRing[index], first);
+    std::memcpy(pDst + first, m_pRing, count - first);
+
+    m_Tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// FNV-1a, byte by byte
+// -----------------------------------------------------------------------------
+uint32_t cCapture::Hash(uint32_t hash, const void* pData, uint32_t size)
+{
+    const uint8_t* pByte = static_cast<const uint8_t*>(pData);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ pByte[i]) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
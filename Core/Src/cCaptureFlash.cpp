@@ -0,0 +1,238 @@
+//==================================================================================
+//==================================================================================
+// File: cCaptureFlash.cpp
+// Description: Capture records (cCapture) to the QSPI flash and USB MIDI dump
+//              (main loop, CAPTURE_ENABLE builds)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cCaptureFlash.h"
+#include "usbd_midi_if.h"
+#include <algorithm>
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Opens the area, prepares a new capture when it is empty
+// -----------------------------------------------------------------------------
+bool cCaptureFlash::Init(DadDrivers::cW25Q128* pFlash, cCapture* pCapture, uint32_t baseAddr, uint32_t size)
+{
+    m_pFlash = pFlash;
+    m_pCapture = pCapture;
+    m_Base = baseAddr;
+    m_DataSize = size - DATA_OFFSET;
+    m_Write = 0;
+
+    uint32_t descriptor[3];
+    if (pFlash->Read(reinterpret_cast<uint8_t*>(descriptor), m_Base, sizeof(descriptor)) != HAL_OK) return false;
+    if (descriptor[0] == MAGIC)
+    {
+        // Previous capture, kept for the dump
+        m_Status = descriptor[2];
+        m_Length = (descriptor[1] != 0xFFFFFFFF) ? descriptor[1] : FindEnd();
+        m_Finalized = true;
+        return false;
+    }
+
+    // New capture: descriptor with the length left erased until the end
+    if (pFlash->EraseBlock64K(m_Base) != HAL_OK) return false;
+    m_Erased = W25Q128_BLOCK_64K_SIZE;
+    uint32_t magic = MAGIC;
+    if (pFlash->Write(reinterpret_cast<uint8_t*>(&magic), m_Base, sizeof(magic)) != HAL_OK) return false;
+
+    m_Length = 0;
+    m_Status = STATUS_INTERRUPTED;
+    m_Finalized = false;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// CC_CAPTURE, handled by the next Poll
+// -----------------------------------------------------------------------------
+void cCaptureFlash::Request(uint8_t value)
+{
+    if (value == 0)        m_StopRequest = true;
+    else if (value == 127) m_ClearRequest = true;
+    else                   m_DumpRequest = true;
+}
+
+// -----------------------------------------------------------------------------
+// Main loop: requests, flash writes, dump
+// -----------------------------------------------------------------------------
+void cCaptureFlash::Poll()
+{
+    if (m_pFlash == nullptr) return;
+
+    if (m_ClearRequest)
+    {
+        m_ClearRequest = false;
+        Clear();
+    }
+    if (m_StopRequest || (m_DumpRequest && !m_Finalized))
+    {
+        m_StopRequest = false;
+        m_pCapture->Stop();            // Applied by the next mixed block
+    }
+
+    if (!m_Finalized)
+    {
+        Drain();
+    }
+    else if (m_DumpRequest)
+    {
+        SendDump();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Writes the published records page by page, erasing the area ahead of them
+// The state is read before the byte count: once stopped, every record is
+// published and the last partial page can be written.
+// -----------------------------------------------------------------------------
+void cCaptureFlash::Drain()
+{
+    for (uint32_t page = 0; page < PAGES_PER_POLL; page++)
+    {
+        cCapture::eState state = m_pCapture->getState();
+        bool ended = (state == cCapture::eState::Stopped) || (state == cCapture::eState::Overflow);
+        uint32_t available = m_pCapture->getAvailable();
+
+        if (available == 0)
+        {
+            if (ended) Finalize((state == cCapture::eState::Overflow) ? STATUS_OVERFLOW : STATUS_STOPPED);
+            return;
+        }
+        if ((available < W25Q128_PAGE_SIZE) && !ended) return;
+
+        if (m_Write + W25Q128_PAGE_SIZE > m_DataSize)
+        {
+            m_pCapture->Stop();
+            Finalize(STATUS_AREA_FULL);
+            return;
+        }
+
+        // Next page, or the erase of its block that ends the pass (the RAM
+        // ring keeps filling meanwhile)
+        uint32_t address = DATA_OFFSET + m_Write;
+        HAL_StatusTypeDef result;
+        if (address >= m_Erased)
+        {
+            result = m_pFlash->EraseBlock64K(m_Base + m_Erased);
+            m_Erased += W25Q128_BLOCK_64K_SIZE;
+            page = PAGES_PER_POLL;
+        }
+        else
+        {
+            uint32_t count = m_pCapture->Read(m_Page, W25Q128_PAGE_SIZE);
+            result = m_pFlash->Write(m_Page, m_Base + address, count);
+            m_Write += count;
+        }
+
+        // Flash error: the records written so far are kept
+        if (result != HAL_OK)
+        {
+            m_pCapture->Stop();
+            Finalize(STATUS_FLASH_ERROR);
+            return;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Programs the length and status of the capture in the descriptor
+// -----------------------------------------------------------------------------
+void cCaptureFlash::Finalize(uint32_t status)
+{
+    uint32_t end[2] = {m_Write, status};
+    m_pFlash->Write(reinterpret_cast<uint8_t*>(end), m_Base + sizeof(uint32_t), sizeof(end));
+    m_Length = m_Write;
+    m_Status = status;
+    m_Finalized = true;
+}
+
+// -----------------------------------------------------------------------------
+// Erases the descriptor block: a capture starts at the next boot
+// -----------------------------------------------------------------------------
+void cCaptureFlash::Clear()
+{
+    m_pCapture->Stop();
+    m_pFlash->EraseBlock64K(m_Base);
+    m_Write = 0;
+    m_Length = 0;
+    m_Finalized = true;
+    m_DumpRequest = false;
+}
+
+// -----------------------------------------------------------------------------
+// Sends the next dump message, kept until the USB accepts it
+// -----------------------------------------------------------------------------
+void cCaptureFlash::SendDump()
+{
+    if (m_MessageSize == 0)
+    {
+        uint8_t* pDst = m_Message;
+        *pDst++ = 0xF0;
+        *pDst++ = SYSEX_ID;
+        *pDst++ = SYSEX_CAPTURE;
+        *pDst++ = VERSION;
+
+        uint32_t count = std::min(DUMP_CHUNK, m_Length - m_DumpOffset);
+        if (count == 0)
+        {
+            pDst = MIDI_SysExPut32(pDst, m_Length);
+            pDst = MIDI_SysExPut32(pDst, 0);
+            pDst = MIDI_SysExPut32(pDst, m_Status);
+        }
+        else
+        {
+            uint8_t data[DUMP_CHUNK];
+            if (m_pFlash->Read(data, m_Base + DATA_OFFSET + m_DumpOffset, count) != HAL_OK) return;
+            pDst = MIDI_SysExPut32(pDst, m_DumpOffset);
+            pDst = MIDI_SysExPut32(pDst, count);
+            for (uint32_t group = 0; group < count; group += 7)
+            {
+                uint8_t* pMsb = pDst++;
+                *pMsb = 0;
+                for (uint32_t i = 0; (i < 7) && (group + i < count); i++)
+                {
+                    *pMsb |= static_cast<uint8_t>((data[group + i] >> 7) << i);
+                    *pDst++ = data[group + i] & 0x7F;
+                }
+            }
+        }
+        *pDst++ = 0xF7;
+        m_MessageSize = static_cast<uint16_t>(pDst - m_Message);
+    }
+
+    if (MIDI_SendSysEx(m_Message, m_MessageSize) != USBD_OK) return;   // Retried at the next pass
+    m_MessageSize = 0;
+    if (m_DumpOffset < m_Length)
+    {
+        m_DumpOffset += std::min(DUMP_CHUNK, m_Length - m_DumpOffset);
+    }
+    else
+    {
+        m_DumpOffset = 0;          // End sent
+        m_DumpRequest = false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Length of an interrupted capture: records up to the first erased page
+// -----------------------------------------------------------------------------
+uint32_t cCaptureFlash::FindEnd()
+{
+    uint32_t length = 0;
+    while (length + W25Q128_PAGE_SIZE <= m_DataSize)
+    {
+        if (m_pFlash->Read(m_Page, m_Base + DATA_OFFSET + length, W25Q128_PAGE_SIZE) != HAL_OK) break;
+        if (std::all_of(m_Page, m_Page + W25Q128_PAGE_SIZE, [](uint8_t b) { return b == 0xFF; })) break;
+        length += W25Q128_PAGE_SIZE;
+    }
+    return length;
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
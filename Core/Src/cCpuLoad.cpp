@@ -0,0 +1,84 @@
+//==================================================================================
+//==================================================================================
+// File: cCpuLoad.cpp
+// Description: CPU load of the audio interrupts and TX deadline meter (DWT
+//              busy cycles against wall-clock cycles)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cCpuLoad.h"
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Ratio in per mille (0 for an empty interval)
+// -----------------------------------------------------------------------------
+static uint32_t PerMille(uint64_t part, uint64_t total)
+{
+    return (total != 0) ? static_cast<uint32_t>(part * 1000 / total) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the core clock and the TX period, clears the counters
+// -----------------------------------------------------------------------------
+void cCpuLoad::Init(uint32_t coreClock, uint32_t txPeriod)
+{
+    m_IsrCycles.store(0, std::memory_order_relaxed);
+    m_TaskCycles.store(0, std::memory_order_relaxed);
+    m_TaskStart = 0;
+    m_TaskIsrStart = 0;
+    m_TxPeriod = txPeriod;
+    m_BlockElapsedMax = 0;
+    m_DeadlineMiss = 0;
+
+    m_WindowCycles = coreClock / 1000 * CPU_LOAD_WINDOW_MS;
+    m_WindowStart = (coreClock != 0) ? CycleCounterGet() : 0;
+    m_WindowBusy = 0;
+    m_SecondLength = coreClock;
+    m_SecondCycles = 0;
+    m_SecondBusy = 0;
+    m_Load = 0;
+    m_AverageLoad = 0;
+    m_PeakLoad = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Main loop: closes the window, and the second once its windows span 1 s
+// An audio task run in progress is counted in the window it ends in.
+// -----------------------------------------------------------------------------
+void cCpuLoad::Update()
+{
+    uint32_t now = CycleCounterGet();
+    uint32_t elapsed = now - m_WindowStart;
+    if ((m_WindowCycles == 0) || (elapsed < m_WindowCycles)) return;
+
+    uint32_t busy = getBusyCycles();
+    uint32_t used = busy - m_WindowBusy;
+    m_WindowStart = now;
+    m_WindowBusy = busy;
+
+    m_Load = PerMille(used, elapsed);
+    if (m_Load > m_PeakLoad) m_PeakLoad = m_Load;
+
+    m_SecondCycles += elapsed;
+    m_SecondBusy += used;
+    if (m_SecondCycles >= m_SecondLength)
+    {
+        m_AverageLoad = PerMille(m_SecondBusy, m_SecondCycles);
+        m_SecondCycles = 0;
+        m_SecondBusy = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Latest block finish in per mille of the TX period
+// -----------------------------------------------------------------------------
+uint32_t cCpuLoad::getDeadlineUse() const
+{
+    return PerMille(m_BlockElapsedMax, m_TxPeriod);
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -1,7 +1,7 @@
 //==================================================================================
 //==================================================================================
 // File: cMixer.cpp
-// Description: Synchronization and mixing of 3 asynchronous S/PDIF audio streams to 48kHz
+// Description: Synchronization and mixing of N asynchronous S/PDIF audio streams to 48kHz
 //              with adaptive drift compensation based on buffer fill level
 //
 // Copyright (c) 2025 Dad Design.
@@ -10,72 +10,312 @@
 
 //**********************************************************************************
 // cMixer.cpp
-// Synchronization and mixing of 3 asynchronous S/PDIF audio streams to 48kHz
+// Synchronization and mixing of N asynchronous S/PDIF audio streams to 48kHz
 // with adaptive drift compensation based on buffer fill level
 //**********************************************************************************
 #include "cMixer.h"
+#include "CycleCounter.h"
+#include "Debug.h"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace Dad {
 
 //**********************************************************************************
-// cCircularBuff
+// Vector helpers (CMSIS-DSP style, 4x unrolled)
 //**********************************************************************************
 
-// =============================================================================
-// Public methods
 // -----------------------------------------------------------------------------
+// pDst[i] = float(sign extended 24-bit pSrc[i]) * scale
+// -----------------------------------------------------------------------------
+static inline void VectorInt24ToFloat(float* pDst, const int32_t* pSrc, float scale, uint32_t size)
+{
+    uint32_t blkCnt = size >> 2;
+    while (blkCnt--)
+    {
+        pDst[0] = static_cast<float>((pSrc[0] << 8) >> 8) * scale;
+        pDst[1] = static_cast<float>((pSrc[1] << 8) >> 8) * scale;
+        pDst[2] = static_cast<float>((pSrc[2] << 8) >> 8) * scale;
+        pDst[3] = static_cast<float>((pSrc[3] << 8) >> 8) * scale;
+        pDst += 4;
+        pSrc += 4;
+    }
+
+    blkCnt = size & 3;
+    while (blkCnt--)
+    {
+        *pDst++ = static_cast<float>((*pSrc++ << 8) >> 8) * scale;
+    }
+}
 
 // -----------------------------------------------------------------------------
-// Pushes samples into the circular buffer
+// pDst[i] += pSrc[i] * scale
 // -----------------------------------------------------------------------------
-void cCircularBuff::Push(int32_t *pSamples)
+static inline void VectorScaleAdd(float* pDst, const float* pSrc, float scale, uint32_t size)
 {
-    // Sign extension 24-bit -> 32-bit then normalization
-    int32_t sampleL = (pSamples[0] << 8) >> 8;  // Left channel
-    int32_t sampleR = (pSamples[1] << 8) >> 8;  // Right channel
+    uint32_t blkCnt = size >> 2;
+    while (blkCnt--)
+    {
+        pDst[0] += pSrc[0] * scale;
+        pDst[1] += pSrc[1] * scale;
+        pDst[2] += pSrc[2] * scale;
+        pDst[3] += pSrc[3] * scale;
+        pDst += 4;
+        pSrc += 4;
+    }
 
-    // Store normalized samples
-    *m_pBuffer++ = COEF_NORMALIZE * sampleL;
-    *m_pBuffer++ = COEF_NORMALIZE * sampleR;
+    blkCnt = size & 3;
+    while (blkCnt--)
+    {
+        *pDst++ += *pSrc++ * scale;
+    }
+}
 
-    // Wrap around if end of buffer reached
-    if (m_pBuffer >= &m_Buffer[CIRCULAR_BUFFER_SIZE * 2])
+// -----------------------------------------------------------------------------
+// pDst[i] = int32(pSrc[i] * scale)
+// -----------------------------------------------------------------------------
+static inline void VectorScaleToInt(int32_t* pDst, const float* pSrc, float scale, uint32_t size)
+{
+    uint32_t blkCnt = size >> 2;
+    while (blkCnt--)
     {
-        m_pBuffer = m_Buffer;
+        pDst[0] = static_cast<int32_t>(pSrc[0] * scale);
+        pDst[1] = static_cast<int32_t>(pSrc[1] * scale);
+        pDst[2] = static_cast<int32_t>(pSrc[2] * scale);
+        pDst[3] = static_cast<int32_t>(pSrc[3] * scale);
+        pDst += 4;
+        pSrc += 4;
     }
 
-    m_Date++;  // Increment internal timestamp
+    blkCnt = size & 3;
+    while (blkCnt--)
+    {
+        *pDst++ = static_cast<int32_t>(*pSrc++ * scale);
+    }
 }
 
+// -----------------------------------------------------------------------------
+// max(|pSrc[i]|)
+// -----------------------------------------------------------------------------
+static inline float VectorPeak(const float* pSrc, uint32_t size)
+{
+    float peak = 0.0f;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        peak = std::max(peak, std::fabs(pSrc[i]));
+    }
+    return peak;
+}
+
+//**********************************************************************************
+// cCircularBuff
+//**********************************************************************************
+
+// =============================================================================
+// Public methods
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 // Pulls samples from the circular buffer with interpolation
 // -----------------------------------------------------------------------------
-void cCircularBuff::Pull(float *pSamples, double date)
+ITCM_CODE void cCircularBuff::Pull(float *pSamples, uint64_t phase)
 {
+    uint32_t intDate = static_cast<uint32_t>(phase >> PHASE_FRAC_BITS);  // Integer read date
+    int32_t intAge = static_cast<int32_t>(m_Date - intDate);             // Age (wrap-safe)
+
     // Return silence if date is out of bounds
-    if ((date > m_Date) || (date + CIRCULAR_BUFFER_SIZE < m_Date))
+    if (!isInRange(intAge))
     {
+        if (intAge < 2) m_UnderrunFrames++;
+        else            m_OverrunFrames++;
         pSamples[0] = pSamples[1] = 0.0f;
         return;
     }
 
-    // Calculate integer and fractional parts of date for interpolation
-    uint32_t intDate = static_cast<uint32_t>(date);          // Integer part
-    float fracDate = static_cast<float>(date - intDate);     // Fractional part
-    uint32_t indexOffset = static_cast<uint32_t>(m_Date) - intDate;  // Offset from current date
+    uint32_t history = getHistory();
+    Convert(intDate + 2 - history, history);
+    Interpolate(pSamples, history - 2, static_cast<uint32_t>(phase) * PHASE_FRAC_TO_FLOAT);
+}
 
-    // Calculate buffer position with wrap-around
-    uint32_t bufferIndex = (m_pBuffer - m_Buffer - (indexOffset * 2) +
-                            (CIRCULAR_BUFFER_SIZE * 2)) % (CIRCULAR_BUFFER_SIZE * 2);
+// -----------------------------------------------------------------------------
+// Pulls a block of interpolated frames, advancing phase by increment
+// The frames read by the whole block are converted (cached) into the window,
+// then read positions are computed for the block and the kernel runs over
+// them in a single loop.
+// -----------------------------------------------------------------------------
+ITCM_CODE void cCircularBuff::PullBlock(float *pSamples, uint64_t& phase, uint64_t increment, uint32_t nbFrames)
+{
+    uint64_t lastPhase = phase + increment * (nbFrames - 1);
+    uint32_t firstDate = static_cast<uint32_t>(phase >> PHASE_FRAC_BITS);
+    uint32_t lastDate = static_cast<uint32_t>(lastPhase >> PHASE_FRAC_BITS);
+    int32_t firstAge = static_cast<int32_t>(m_Date - firstDate);
+    int32_t lastAge = static_cast<int32_t>(m_Date - lastDate);
+    uint32_t history = getHistory();
 
-    // Linear interpolation between current and next sample
-    uint32_t nextIndex = (bufferIndex + 2) % (CIRCULAR_BUFFER_SIZE * 2);  // Next sample position
-    float oneMinusFrac = 1.0f - fracDate;                                 // Weight for current sample
+    // Positions are increasing: only the block ends need a bounds check
+    if (!isInRange(firstAge) || !isInRange(lastAge) || (lastDate - firstDate + history > PULL_WINDOW_FRAMES))
+    {
+        for (uint32_t i = 0; i < nbFrames; i++)
+        {
+            Pull(&pSamples[i * 2], phase);
+            phase += increment;
+        }
+        return;
+    }
+
+    // Convert the frames read by the block, the window starts on the oldest
+    uint32_t windowDate = firstDate + 2 - history;
+    Convert(windowDate, lastDate - firstDate + history);
+
+    // Compute all read positions (window frame indexes)
+    uint32_t frameIndex[TX_NB_FRAMES];
+    float fracDate[TX_NB_FRAMES];
+
+    for (uint32_t i = 0; i < nbFrames; i++)
+    {
+        frameIndex[i] = static_cast<uint32_t>(phase >> PHASE_FRAC_BITS) - windowDate;
+        fracDate[i] = static_cast<uint32_t>(phase) * PHASE_FRAC_TO_FLOAT;
+        phase += increment;
+    }
+
+    // Gather and interpolate, kernel selected once per block
+    switch (m_Interpolation)
+    {
+        case eInterpolation::Linear:
+            for (uint32_t i = 0; i < nbFrames; i++, pSamples += 2)
+            {
+                InterpolateLinear(pSamples, frameIndex[i], fracDate[i]);
+            }
+            break;
+
+        case eInterpolation::Cubic:
+            for (uint32_t i = 0; i < nbFrames; i++, pSamples += 2)
+            {
+                InterpolateCubic(pSamples, frameIndex[i], fracDate[i]);
+            }
+            break;
+
+        default:
+            for (uint32_t i = 0; i < nbFrames; i++, pSamples += 2)
+            {
+                InterpolateSinc(pSamples, frameIndex[i], fracDate[i]);
+            }
+            break;
+    }
+}
+
+// =============================================================================
+// Private methods
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Converts ring frames into the cache and points the window to them
+// Consecutive blocks overlap by the kernel length: frames already converted
+// are reused, so each frame is converted once, when first read. A window
+// outside the cached frames (read position moved) restarts the cache, a full
+// cache moves the frames of the window to its start. The frames read are
+// older than the write date, the DMA no longer changes them.
+// -----------------------------------------------------------------------------
+ITCM_CODE void cCircularBuff::Convert(uint32_t date, uint32_t nbFrames)
+{
+    if ((static_cast<int32_t>(date - (m_CacheDate - m_CacheFrames)) < 0) ||
+        (static_cast<int32_t>(date - m_CacheDate) > 0))
+    {
+        m_CacheDate = date;
+        m_CacheEnd = 0;
+        m_CacheFrames = 0;
+    }
+
+    int32_t nbNew = static_cast<int32_t>(date + nbFrames - m_CacheDate);
+    if (nbNew > 0)
+    {
+        PROFILE_START(start);
+        if (m_CacheEnd + nbNew > PULL_CACHE_FRAMES)
+        {
+            uint32_t nbKeep = m_CacheDate - date;
+            std::memmove(m_Cache, &m_Cache[(m_CacheEnd - nbKeep) * 2], nbKeep * 2 * sizeof(float));
+            m_CacheEnd = nbKeep;
+            m_CacheFrames = nbKeep;
+        }
+
+        // Sign extension 24-bit -> 32-bit then normalization, in two parts
+        // when the frames cross the ring end
+        uint32_t frameIndex = m_CacheDate & CIRCULAR_BUFFER_MASK;
+        uint32_t nbFirst = std::min(static_cast<uint32_t>(nbNew), CIRCULAR_BUFFER_SIZE - frameIndex);
+        float* pDst = &m_Cache[m_CacheEnd * 2];
+        VectorInt24ToFloat(pDst, &m_pRing[frameIndex * 2], COEF_NORMALIZE, nbFirst * 2);
+        VectorInt24ToFloat(pDst + nbFirst * 2, m_pRing, COEF_NORMALIZE, (nbNew - nbFirst) * 2);
+
+        m_CacheDate += nbNew;
+        m_CacheEnd += nbNew;
+        m_CacheFrames += nbNew;
+        PROFILE_STOP(start, PROBE_CONVERT);
+    }
+
+    m_pWindow = &m_Cache[(m_CacheEnd - (m_CacheDate - date)) * 2];
+}
+
+// -----------------------------------------------------------------------------
+// Interpolates one frame at window frame index with fractional position
+// -----------------------------------------------------------------------------
+inline void cCircularBuff::Interpolate(float *pSamples, uint32_t frameIndex, float frac) const
+{
+    switch (m_Interpolation)
+    {
+        case eInterpolation::Linear: InterpolateLinear(pSamples, frameIndex, frac); break;
+        case eInterpolation::Cubic:  InterpolateCubic(pSamples, frameIndex, frac); break;
+        default:                     InterpolateSinc(pSamples, frameIndex, frac); break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Linear interpolation between current and next frame
+// -----------------------------------------------------------------------------
+inline void cCircularBuff::InterpolateLinear(float *pSamples, uint32_t frameIndex, float frac) const
+{
+    const float* pFrame = &m_pWindow[frameIndex * 2];  // Current frame, next one follows
+    float oneMinusFrac = 1.0f - frac;                 // Weight for current sample
 
     // Interpolate left and right channels
-    pSamples[0] = m_Buffer[bufferIndex] * oneMinusFrac + m_Buffer[nextIndex] * fracDate;
-    pSamples[1] = m_Buffer[bufferIndex + 1] * oneMinusFrac + m_Buffer[nextIndex + 1] * fracDate;
+    pSamples[0] = pFrame[0] * oneMinusFrac + pFrame[2] * frac;
+    pSamples[1] = pFrame[1] * oneMinusFrac + pFrame[3] * frac;
+}
+
+// -----------------------------------------------------------------------------
+// 4 points cubic Hermite (Catmull-Rom) interpolation, Farrow structure:
+// the polynomial coefficients are computed from the frames and evaluated
+// with Horner's scheme, no table is needed for the fractional position.
+// The window ends on the frame following the integer date like the other
+// kernels, so the curve is evaluated between frames -1 and 0 (one frame of
+// constant delay, absorbed by the fill level target).
+// -----------------------------------------------------------------------------
+inline void cCircularBuff::InterpolateCubic(float *pSamples, uint32_t frameIndex, float frac) const
+{
+    const float* pFrame = &m_pWindow[(frameIndex - 2) * 2];
+
+    for (uint32_t ch = 0; ch < 2; ch++)
+    {
+        float xm1 = pFrame[ch];
+        float x0  = pFrame[ch + 2];
+        float x1  = pFrame[ch + 4];
+        float x2  = pFrame[ch + 6];
+
+        float c1 = 0.5f * (x1 - xm1);
+        float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        pSamples[ch] = ((c3 * frac + c2) * frac + c1) * frac + x0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Polyphase sinc: taps end on the frame following the integer date
+// -----------------------------------------------------------------------------
+inline void cCircularBuff::InterpolateSinc(float *pSamples, uint32_t frameIndex, float frac) const
+{
+    uint32_t firstIndex = frameIndex + 2 - m_pSinc->getNbTaps();
+    m_pSinc->Interpolate(pSamples, &m_pWindow[firstIndex * 2], frac);
 }
 
 //**********************************************************************************
@@ -86,33 +326,730 @@ void cCircularBuff::Pull(float *pSamples, double date)
 // Public methods
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+// Constructor: computes the sinc coefficient banks once
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+cMixer<NbInputs>::cMixer()
+{
+    m_Sinc16.Init();
+    m_Sinc32.Init();
+    m_Sinc64.Init();
+
+    // Estimated kernel costs until MeasureInterpolationCost is called
+    m_InterpolationCycles[static_cast<uint8_t>(eInterpolation::Linear)] = 30;
+    m_InterpolationCycles[static_cast<uint8_t>(eInterpolation::Cubic)]  = 45;
+    m_InterpolationCycles[static_cast<uint8_t>(eInterpolation::Sinc16)] = 100;
+    m_InterpolationCycles[static_cast<uint8_t>(eInterpolation::Sinc32)] = 170;
+    m_InterpolationCycles[static_cast<uint8_t>(eInterpolation::Sinc64)] = 300;
+
+    // Default kernel, downgraded to linear if the estimated budget is exceeded
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        m_Params.Edit().Interpolation[ch] = eInterpolation::Linear;
+        m_Buffer[ch].setInterpolator(eInterpolation::Linear, nullptr);
+        m_pStream[ch] = nullptr;                 // No receiver until attachInput
+    }
+    m_pCapture = nullptr;                        // No capture until attachCapture
+    m_Capturing = false;
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        setInterpolation(ch, eInterpolation::Sinc32);
+    }
+
+    setLoopBandwidth(PLL_ACQUIRE_BW, PLL_TRACK_BW);
+    Initialise();
+}
+
+// -----------------------------------------------------------------------------
+// Measures the cost of each kernel with the DWT cycle counter
+// The ring of input 0 (DMA not started, contents irrelevant) is read over
+// several blocks at a non integer ratio, then cleared. The measure includes
+// the sample conversion and the read position computation of PullBlock.
+// Estimated costs are kept if the input has no ring attached. The kernels
+// selected so far were checked with the estimates and the start-up clock:
+// they are checked again with the final values.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::MeasureInterpolationCost()
+{
+    constexpr uint32_t NB_BLOCKS = 16;
+    cCircularBuff& buffer = m_Buffer[0];
+    if (!buffer.hasStorage())
+    {
+        fitInterpolation();
+        return;
+    }
+
+    CycleCounterInit();
+
+    buffer.Clear();
+    buffer.setWriteIndex(CIRCULAR_BUFFER_SIZE - 1);
+
+    const uint64_t increment = static_cast<uint64_t>((44100.0 / OUTPUT_SAMPLE_RATE) * PHASE_ONE);
+    for (uint8_t k = 0; k < NB_INTERPOLATIONS; k++)
+    {
+        eInterpolation interp = static_cast<eInterpolation>(k);
+        buffer.setInterpolator(interp, getSincBank(interp));
+
+        uint64_t phase = buffer.getPhase(CIRCULAR_BUFFER_SIZE / 2);
+        uint32_t start = CycleCounterGet();
+        for (uint32_t b = 0; b < NB_BLOCKS; b++)
+        {
+            buffer.PullBlock(m_BlockIn, phase, increment, TX_NB_FRAMES);
+        }
+        uint32_t cycles = CycleCounterGet() - start;
+
+        m_InterpolationCycles[k] = (cycles + NB_BLOCKS * TX_NB_FRAMES - 1) / (NB_BLOCKS * TX_NB_FRAMES);
+    }
+
+    // Restore the selected kernel and the input state
+    buffer.setInterpolator(m_Active.Interpolation[0], getSincBank(m_Active.Interpolation[0]));
+    buffer.Clear();
+    m_RateIn[0].Reset();
+
+    fitInterpolation();
+}
+
+// -----------------------------------------------------------------------------
+// Steps the most expensive selected kernel down to the next cheaper one until
+// the selection fits the budget (or all inputs are linear)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::fitInterpolation()
+{
+    sMixParams& params = m_Params.Edit();
+    bool changed = false;
+    for (;;)
+    {
+        uint32_t cycles = 0;
+        uint8_t costliest = 0;
+        for (uint8_t ch = 0; ch < NbInputs; ch++)
+        {
+            cycles += getInterpolationCycles(params.Interpolation[ch]);
+            if (getInterpolationCycles(params.Interpolation[ch]) > getInterpolationCycles(params.Interpolation[costliest]))
+            {
+                costliest = ch;
+            }
+        }
+        eInterpolation& interp = params.Interpolation[costliest];
+        if ((cycles * TX_NB_FRAMES <= getInterpolationBudget()) || (interp == eInterpolation::Linear)) break;
+
+        interp = static_cast<eInterpolation>(static_cast<uint8_t>(interp) - 1);
+        changed = true;
+    }
+    if (changed) m_Params.Publish();
+}
+
+// -----------------------------------------------------------------------------
+// Interpolation budget in CPU cycles per TX callback
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+uint32_t cMixer<NbInputs>::getInterpolationBudget() const
+{
+    uint32_t cyclesPerCallback = (SystemCoreClock / OUTPUT_SAMPLE_RATE) * TX_NB_FRAMES;
+    return cyclesPerCallback / 100 * INTERPOLATION_BUDGET_PERCENT;
+}
+
+// -----------------------------------------------------------------------------
+// Checks the budget of the new kernel combination and publishes it if it fits
+// Called from the USB interrupt, which preempts the audio task: the buffer
+// kernel is only switched by mixChannel, so a block never sees a partially
+// applied selection.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+bool cMixer<NbInputs>::setInterpolation(uint8_t input, eInterpolation interp)
+{
+    if (input >= NbInputs) return false;
+
+    sMixParams& params = m_Params.Edit();
+    uint32_t cycles = 0;
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        cycles += getInterpolationCycles((ch == input) ? interp : params.Interpolation[ch]);
+    }
+    if (cycles * TX_NB_FRAMES > getInterpolationBudget())
+    {
+        return false;
+    }
+
+    params.Interpolation[input] = interp;
+    m_Params.Publish();
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Gain setters, published for the next block (control side)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::setGain(uint8_t input, float gain)
+{
+    if (input >= NbInputs) return;
+    m_Params.Edit().Gain[input] = gain;
+    m_Params.Publish();
+}
+
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::setGainMaster(float gain)
+{
+    m_Params.Edit().GainMaster = gain;
+    m_Params.Publish();
+}
+
+// -----------------------------------------------------------------------------
+// Sets the drift control loop bandwidths for acquisition and tracking
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::setLoopBandwidth(float acquireHz, float trackHz)
+{
+    setLoopGains(0, acquireHz);
+    setLoopGains(1, trackHz);
+}
+
 // -----------------------------------------------------------------------------
 // Initializes mixer state and resets all parameters
 // -----------------------------------------------------------------------------
-void cMixer::Initialise()
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::Initialise()
+{
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        m_Buffer[ch].Clear();                        // Clear input buffer
+        m_Buffer[ch].ClearCounters();
+        m_DriftFactor[ch] = 0.0;                     // Drift and nominal factors
+        m_NominalFactor[ch] = 1.0f;
+        m_FeedForward[ch] = 1.0;
+        m_ReadPhase[ch] = 0;                         // Read phase
+        m_SampleRate[ch] = eSampleRate::NoSync;      // Sample rate and gain
+        m_Params.Edit().Gain[ch] = 1.0f;
+        resetLoop(ch, eLockState::NoSync);           // Drift control loop
+        m_RateIn[ch].Init(std::max(RATE_EST_MIN_WINDOW, RATE_EST_WINDOW_FRAMES / RX_MARK_FRAMES),
+                          RATE_EST_MIN_MARKS);       // Timestamp rate estimate (ring halves)
+        m_SourceRate[ch] = 0;
+        m_BlockSourceRate[ch] = 0;
+        m_MoveTimestamp[ch] = 0;                     // DMA progress
+        m_Moving[ch] = false;
+        m_RxMark[ch].Clear();                        // RX timestamps
+        m_RxOverflow[ch] = 0;
+        m_ResyncRequest[ch].store(0, std::memory_order_relaxed);  // Stream restarts
+        m_ResyncTimestamp[ch] = 0;
+        m_ResyncHandled[ch] = 0;
+        m_Resyncing[ch] = false;
+        m_RecoveryCycles[ch] = 0;
+        m_RecoveryCyclesMax[ch] = 0;
+        m_Peak[ch] = 0.0f;                           // Meters
+        m_UnderrunCount[ch] = 0;                     // Starvation
+        m_OverrunCount[ch] = 0;
+        m_Starved[ch] = false;
+        m_FadeInterp[ch] = eInterpolation::Linear;   // No kernel switch in progress
+        m_FadeFrames[ch] = KERNEL_FADE_FRAMES;
+    }
+    m_EventCount.store(0, std::memory_order_relaxed);
+    m_TxRestart.store(0, std::memory_order_relaxed);
+    m_TxRestartHandled = 0;
+
+    CycleCounterInit();                              // Callback timestamps
+    m_RateOut.Init(std::max(RATE_EST_MIN_WINDOW, RATE_EST_WINDOW_FRAMES / TX_NB_FRAMES),
+                   std::max(RATE_EST_MIN_CALLBACKS, RATE_EST_MIN_FRAMES / TX_NB_FRAMES));
+    m_OutDate = 0;
+    m_PullTimestamp = 0;
+    m_SyncTimeout = SystemCoreClock / 1000 * SYNC_TIMEOUT_MS;
+
+    // Queues, TX_QUEUE_PREFILL silent blocks ahead of the TX callback
+    m_TxRequest.Clear();
+    m_TxQueue.Clear();
+    for (uint32_t i = 0; i < TX_QUEUE_PREFILL; i++)
+    {
+        std::memset(m_TxQueue.Reserve(), 0, sizeof(sTxBlock));
+        m_TxQueue.Commit();
+    }
+    m_TxUnderrun = 0;
+    m_TxRequestOverflow = 0;
+    m_MixCycles = 0;
+    m_MixCyclesMax = 0;
+    m_CpuLoad.Init(SystemCoreClock,
+                   static_cast<uint32_t>(static_cast<uint64_t>(SystemCoreClock) * TX_NB_FRAMES / OUTPUT_SAMPLE_RATE));
+    m_PeakOut = 0.0f;
+    m_ClipCount = 0;
+    m_PeakReset.store(0, std::memory_order_relaxed);
+    m_PeakResetHandled = 0;
+
+    // Unity gains, active from the first block (audio task not running yet)
+    m_Params.Edit().GainMaster = 1.0f;
+    m_Params.Publish();
+    m_Params.Fetch(m_Active);
+}
+
+// -----------------------------------------------------------------------------
+// Attaches the ring storage and the receiver of an input
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::attachInput(uint8_t input, int32_t* pRing, const cInputStream* pStream)
+{
+    m_Buffer[input].setStorage(pRing);
+    m_Buffer[input].Clear();
+    m_pStream[input] = pStream;
+}
+
+// -----------------------------------------------------------------------------
+// Attaches the block records and writes the stream header
+// The replay starts from a mixer in its initial state: the first record
+// holds the whole parameter set and the source rates are recorded from 0.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::attachCapture(cCapture* pCapture)
+{
+    m_pCapture = pCapture;
+    m_CaptureParams = true;
+    for (uint8_t ch = 0; ch < NbInputs; ch++) m_CaptureSourceRate[ch] = 0;
+    if ((pCapture == nullptr) || !pCapture->BeginRecord()) return;
+
+    pCapture->Put8('D');
+    pCapture->Put8('C');
+    pCapture->Put8('A');
+    pCapture->Put8('P');
+    pCapture->Put8(CAPTURE_VERSION);
+    pCapture->Put8(NbInputs);
+    pCapture->Put8(AUDIO_PROFILE);
+    pCapture->Put8(pCapture->getSampleMask());
+    pCapture->Put16(TX_NB_FRAMES);
+    pCapture->Put16(CIRCULAR_BUFFER_SIZE);
+    pCapture->Put32(OUTPUT_SAMPLE_RATE);
+    pCapture->Put32(SystemCoreClock);
+    pCapture->EndRecord();
+}
+
+// -----------------------------------------------------------------------------
+// Rate ratio measured from the callback timestamps
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+double cMixer<NbInputs>::getMeasuredRatio(uint8_t input) const
 {
-    // Clear input buffers
-    BuffIn1.Clear();
-    BuffIn2.Clear();
-    BuffIn3.Clear();
+    if (!m_RateIn[input].isValid() || !m_RateOut.isValid() || m_RateOut.getRate() <= 0.0)
+    {
+        return 0.0;
+    }
+    return m_RateIn[input].getRate() / m_RateOut.getRate();
+}
 
-    // Initialize drift and nominal factors
-    m_Drif_Factor1 = m_Drif_Factor2 = m_Drif_Factor3 = 0.0f;
-    m_nominal_factor1 = m_nominal_factor2 = m_nominal_factor3 = 1.0f;
+// -----------------------------------------------------------------------------
+// Queues the timestamp of an RX ring half (RX DMA half / complete callback)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::markInput(uint8_t input, uint32_t frameIndex, uint32_t timestamp)
+{
+    sRxMark* pMark = m_RxMark[input].Reserve();
+    if (pMark != nullptr)
+    {
+        pMark->Timestamp = timestamp;
+        pMark->FrameIndex = frameIndex;
+        m_RxMark[input].Commit();
+    }
+    else
+    {
+        m_RxOverflow[input]++;  // Audio task late, the estimate skips a point
+    }
+    m_CpuLoad.IsrDone(timestamp);
+}
 
-    // Reset counters and output dates
-    m_ctPull = m_ctIN1 = m_ctIN2 = m_ctIN3 = 0;
-    m_DateOut1 = m_DateOut2 = m_DateOut3 = 0.0;
+// -----------------------------------------------------------------------------
+// Requests the resynchronization of an input whose receiver restarted its
+// DMA (error callback). The ring position restarts at 0 and the timestamps
+// queued before the error belong to the old stream.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::resyncInput(uint8_t input, uint32_t timestamp)
+{
+    if (input >= NbInputs) return;
+    m_ResyncTimestamp[input] = timestamp;
+    m_ResyncRequest[input].store(m_ResyncRequest[input].load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_release);
+}
 
-    // Reset sample rates and gains
-    m_SampleRate1 = m_SampleRate2 = m_SampleRate3 = eSampleRate::NoSync;
-    m_Gain1 = m_Gain2 = m_Gain3 = m_GainMaster = 1.0f;
+// -----------------------------------------------------------------------------
+// Signals a TX DMA restart (error callback): the callback period was broken
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::restartOutput()
+{
+    m_TxRestart.store(m_TxRestart.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Gives the next mixed block to the TX DMA callback and requests a new one
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::fetchSamples(int32_t* pSamples, uint32_t timestamp)
+{
+    const sTxBlock* pBlock = m_TxQueue.Front();
+    if (pBlock != nullptr)
+    {
+        std::memcpy(pSamples, pBlock->Samples, sizeof(pBlock->Samples));
+        m_TxQueue.Release();
+    }
+    else
+    {
+        std::memset(pSamples, 0, sizeof(sTxBlock));  // Audio task late
+        m_TxUnderrun++;
+    }
+
+    sTxRequest* pRequest = m_TxRequest.Reserve();
+    if (pRequest != nullptr)
+    {
+        captureInputs(*pRequest, timestamp);
+        m_TxRequest.Commit();
+    }
+    else
+    {
+        m_TxRequestOverflow++;  // Audio task stalled for TX_QUEUE_DEPTH periods
+    }
+    m_CpuLoad.IsrDone(timestamp);
+}
+
+// -----------------------------------------------------------------------------
+// Audio task: mixes one block for each TX request. A block mixed while the
+// queue already holds TX_QUEUE_PREFILL blocks (run late after an underrun) is
+// dropped so the output latency stays constant.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::Process()
+{
+    m_CpuLoad.TaskBegin();
+    const sTxRequest* pRequest;
+    while ((pRequest = m_TxRequest.Front()) != nullptr)
+    {
+        sTxBlock* pBlock = (m_TxQueue.getCount() < TX_QUEUE_PREFILL) ? m_TxQueue.Reserve() : nullptr;
+        if (pBlock != nullptr)
+        {
+            mixBlock(pBlock->Samples, *pRequest);
+            m_TxQueue.Commit();
+        }
+        else
+        {
+            mixBlock(m_TxDiscard.Samples, *pRequest);
+        }
+        m_TxRequest.Release();
+    }
+    m_CpuLoad.TaskDone();
+}
+
+// -----------------------------------------------------------------------------
+// Pulls mixed samples from all synchronized buffers
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::pullSamples(int32_t* pSamples, uint32_t timestamp)
+{
+    sTxRequest request;
+    captureInputs(request, timestamp);
+    mixBlock(pSamples, request);
+    m_CpuLoad.IsrDone(timestamp);
+}
+
+// =============================================================================
+// Private methods
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Reads the DMA positions of the inputs (TX callback)
+// NDTR counts the samples left before the ring end, a frame is complete once
+// both its samples are written.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::captureInputs(sTxRequest& request, uint32_t timestamp) const
+{
+    request.Timestamp = timestamp;
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        const cInputStream* pStream = m_pStream[ch];
+        if ((pStream == nullptr) || !pStream->isValid())
+        {
+            request.WriteIndex[ch] = STREAM_MUTED;
+        }
+        else
+        {
+            request.WriteIndex[ch] = (CIRCULAR_BUFFER_SAMPLES - pStream->getRemaining()) / 2;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Applies the captured DMA positions and the queued RX timestamps (audio task)
+// The DMA counter gives the ring date, but only to the frame at the TX
+// instants: when the rates are close to a simple ratio its rounding is a slow
+// sawtooth the regression cannot average. The rate estimate is therefore fed
+// with the ring halves, whose position is exact, taken as the half nearest
+// to the current date (marks are less than half a ring old or ahead).
+// A muted input drops its history and is stopped by updateBufferSync.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::updateInputs(const sTxRequest& request)
+{
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        cSPSCQueue<sRxMark, RX_MARK_QUEUE_DEPTH>& marks = m_RxMark[ch];
+        uint32_t writeIndex = request.WriteIndex[ch];
+
+        // Input flags of the record, written once its values are appended
+        uint32_t flagsPosition = 0;
+        uint8_t flags = 0;
+        if (m_Capturing)
+        {
+            flagsPosition = m_pCapture->Tell();
+            m_pCapture->Put8(0);
+        }
+
+        // Receiver restarted: drop the input as for a mute, it starts again
+        // like a new stream once its DMA progress and rate are measured
+        uint32_t resync = m_ResyncRequest[ch].load(std::memory_order_acquire);
+        if (resync != m_ResyncHandled[ch])
+        {
+            m_ResyncHandled[ch] = resync;
+            logEvent(ch, eStreamEvent::Resync, m_ResyncTimestamp[ch], m_Buffer[ch].getAge(m_ReadPhase[ch]), 0);
+            m_Resyncing[ch] = true;
+            if (m_LockState[ch] != eLockState::NoSync) stopInput(ch);
+            writeIndex = STREAM_MUTED;
+            if (m_Capturing)
+            {
+                flags |= CAPTURE_RESYNC;
+                m_pCapture->Put32(m_ResyncTimestamp[ch]);
+            }
+        }
+
+        // Receiver rate, read once: the receiver interrupt may change it
+        // before updateBufferSync uses it
+        m_BlockSourceRate[ch] = m_SourceRate[ch];
+        if (m_Capturing && (m_BlockSourceRate[ch] != m_CaptureSourceRate[ch]))
+        {
+            flags |= CAPTURE_SOURCE_RATE;
+            m_CaptureSourceRate[ch] = m_BlockSourceRate[ch];
+            m_pCapture->Put32(m_BlockSourceRate[ch]);
+        }
+
+        if (writeIndex == STREAM_MUTED)
+        {
+            while (marks.Front() != nullptr) marks.Release();
+            m_Buffer[ch].Clear();            // DMA laps untracked, cached frames stale
+            m_RateIn[ch].Reset();
+            m_Moving[ch] = false;
+            if (m_Capturing) m_pCapture->Patch8(flagsPosition, flags);
+            continue;
+        }
+
+        // Ring date, DMA progress for the stall detection
+        cCircularBuff& buffer = m_Buffer[ch];
+        uint32_t date = buffer.getDate();
+        buffer.setWriteIndex(writeIndex);
+        if (buffer.getDate() != date)
+        {
+            m_MoveTimestamp[ch] = request.Timestamp;
+            m_Moving[ch] = true;
+        }
+        else if (static_cast<int32_t>(request.Timestamp - m_MoveTimestamp[ch]) >= static_cast<int32_t>(m_SyncTimeout))
+        {
+            m_Moving[ch] = false;
+        }
+        if (m_Capturing && (buffer.getDate() != date) && (m_pCapture->getSampleMask() & (1U << ch)))
+        {
+            flags |= CAPTURE_FRAMES;
+            captureFrames(ch, date);
+        }
+
+        // Ring halves queued so far, later ones are left to the next block
+        uint32_t nbMarks = marks.getCount();
+        for (uint32_t i = 0; i < nbMarks; i++)
+        {
+            const sRxMark* pMark = marks.Front();
+            date = buffer.getDate();
+            date += ((pMark->FrameIndex - date + CIRCULAR_BUFFER_SIZE / 2) & CIRCULAR_BUFFER_MASK) - CIRCULAR_BUFFER_SIZE / 2;
+            m_RateIn[ch].Update(pMark->Timestamp, date);
+            if (m_Capturing)
+            {
+                m_pCapture->Put16(static_cast<uint16_t>(pMark->FrameIndex));
+                m_pCapture->Put32(pMark->Timestamp);
+            }
+            marks.Release();
+        }
+        if (m_Capturing) m_pCapture->Patch8(flagsPosition, flags | (nbMarks << CAPTURE_MARK_SHIFT));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Mixes one block for a TX request
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::mixBlock(int32_t* pSamples, const sTxRequest& request)
+{
+    uint32_t start = CycleCounterGet();
+    uint8_t captureFlags = 0;
+    m_Capturing = (m_pCapture != nullptr) && m_pCapture->BeginRecord();
+
+    // User parameters published since the previous block
+    if (m_Params.Fetch(m_Active)) captureFlags |= CAPTURE_PARAMS;
+
+    // Output clock reference for this block and input positions, the
+    // estimate restarts after a TX DMA restart
+    uint32_t txRestart = m_TxRestart.load(std::memory_order_acquire);
+    if (txRestart != m_TxRestartHandled)
+    {
+        m_TxRestartHandled = txRestart;
+        m_RateOut.Reset();
+        captureFlags |= CAPTURE_TX_RESTART;
+    }
+    if (m_Capturing) captureRequest(request, captureFlags);
+    m_PullTimestamp = request.Timestamp;
+    m_RateOut.Update(request.Timestamp, m_OutDate);
+    updateInputs(request);
+
+    // Meters read since the previous block: start new peaks
+    uint32_t peakReset = m_PeakReset.load(std::memory_order_acquire);
+    if (peakReset != m_PeakResetHandled)
+    {
+        m_PeakResetHandled = peakReset;
+        for (uint8_t ch = 0; ch < NbInputs; ch++) m_Peak[ch] = 0.0f;
+        m_PeakOut = 0.0f;
+        m_CpuLoad.resetBlockPeak();
+    }
+
+    // Detect and update sample rates
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        updateBufferSync(ch);
+    }
+
+    // Interpolate each input as a block and accumulate
+    for (uint32_t i = 0; i < TX_BUFFER_SIZE; i++)
+    {
+        m_BlockMix[i] = 0.0f;
+    }
+
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        mixChannel(ch, m_BlockMix);
+    }
+
+    // Output meter, then apply master gain and denormalize
+    float peakOut = VectorPeak(m_BlockMix, TX_BUFFER_SIZE) * m_Active.GainMaster;
+    if (peakOut > m_PeakOut) m_PeakOut = peakOut;
+    if (peakOut > 1.0f) m_ClipCount++;
+    VectorScaleToInt(pSamples, m_BlockMix, m_Active.GainMaster * COEF_DENORMALIZE, TX_BUFFER_SIZE);
+    if (m_Capturing) captureHashes(pSamples);
+
+    m_OutDate += TX_NB_FRAMES;  // Output frames produced
+    publishStatus();
+
+    m_MixCycles = CycleCounterGet() - start;
+    if (m_MixCycles > m_MixCyclesMax) m_MixCyclesMax = m_MixCycles;
+    m_CpuLoad.BlockDone(request.Timestamp);
+    PROFILE_STOP(start, PROBE_MIX_BLOCK);
+}
+
+// -----------------------------------------------------------------------------
+// Opens the block record: TX request, then the parameter set when a new one
+// was fetched (and on the first record)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::captureRequest(const sTxRequest& request, uint8_t flags)
+{
+    cCapture& capture = *m_pCapture;
+    if (m_CaptureParams) flags |= CAPTURE_PARAMS;
+    m_CaptureParams = false;
+
+    capture.Put8(CAPTURE_BLOCK);
+    capture.Put8(flags);
+    capture.Put32(request.Timestamp);
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        uint32_t writeIndex = request.WriteIndex[ch];
+        capture.Put16((writeIndex == STREAM_MUTED) ? CAPTURE_MUTED : static_cast<uint16_t>(writeIndex));
+    }
+
+    if (flags & CAPTURE_PARAMS)
+    {
+        for (uint8_t ch = 0; ch < NbInputs; ch++) capture.PutFloat(m_Active.Gain[ch]);
+        capture.PutFloat(m_Active.GainMaster);
+        for (uint8_t ch = 0; ch < NbInputs; ch++) capture.Put8(static_cast<uint8_t>(m_Active.Interpolation[ch]));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Records the ring frames written from fromDate to the current write date
+// (complete frames, the DMA writes past them)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::captureFrames(uint8_t input, uint32_t fromDate)
+{
+    cCapture& capture = *m_pCapture;
+    const int32_t* pRing = m_Buffer[input].getStorage();
+    uint32_t first = fromDate & CIRCULAR_BUFFER_MASK;
+    uint32_t count = m_Buffer[input].getDate() - fromDate;
+    uint32_t nbFirst = std::min(count, CIRCULAR_BUFFER_SIZE - first);
+
+    capture.Put16(static_cast<uint16_t>(first));
+    capture.Put16(static_cast<uint16_t>(count));
+    capture.PutSamples24(&pRing[first * 2], nbFirst * 2);
+    capture.PutSamples24(pRing, (count - nbFirst) * 2);
+}
+
+// -----------------------------------------------------------------------------
+// Publishes the drift state of the inputs after a block: one coherent set for
+// the main loop, which cannot read the 64-bit phase and the double estimates
+// of the audio path as single words
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::publishStatus()
+{
+    sStatus& status = m_Status.Edit();
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        sInputStatus& input = status.Input[ch];
+        input.DriftFactor = m_DriftFactor[ch];
+        input.MeasuredRatio = getMeasuredRatio(ch);
+        input.BufferAge = m_Buffer[ch].getAge(m_ReadPhase[ch]);
+        input.LoopError = m_LoopError[ch];
+        input.LockState = m_LockState[ch];
+    }
+    m_Status.Publish();
+}
+
+// -----------------------------------------------------------------------------
+// Closes the block record with the output and drift state hashes
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::captureHashes(const int32_t* pSamples)
+{
+    uint32_t state = cCapture::HASH_INIT;
+    for (uint8_t ch = 0; ch < NbInputs; ch++)
+    {
+        state = cCapture::Hash(state, &m_ReadPhase[ch], sizeof(m_ReadPhase[ch]));
+        state = cCapture::Hash(state, &m_DriftFactor[ch], sizeof(m_DriftFactor[ch]));
+        state = cCapture::Hash(state, &m_LockState[ch], sizeof(m_LockState[ch]));
+    }
+
+    m_pCapture->Put32(cCapture::Hash(cCapture::HASH_INIT, pSamples, TX_BUFFER_SIZE * sizeof(int32_t)));
+    m_pCapture->Put32(state);
+    m_pCapture->EndRecord();
+}
+
+// -----------------------------------------------------------------------------
+// Gets the sinc bank of a kernel (nullptr for linear and cubic)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+const cPolyphaseSinc* cMixer<NbInputs>::getSincBank(eInterpolation interp) const
+{
+    switch (interp)
+    {
+        case eInterpolation::Sinc16: return &m_Sinc16;
+        case eInterpolation::Sinc32: return &m_Sinc32;
+        case eInterpolation::Sinc64: return &m_Sinc64;
+        default: return nullptr;
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Converts sample rate enum to floating point value
 // -----------------------------------------------------------------------------
-float cMixer::getSampleRate(eSampleRate sr)
+template <uint8_t NbInputs>
+float cMixer<NbInputs>::getSampleRate(eSampleRate sr) const
 {
     switch (sr)
     {
@@ -126,34 +1063,27 @@ float cMixer::getSampleRate(eSampleRate sr)
 }
 
 // -----------------------------------------------------------------------------
-// Detects sample rate based on received sample count
+// Matches a measured rate to a standard sample rate (SYNC_RATE_TOLERANCE)
 // -----------------------------------------------------------------------------
-eSampleRate cMixer::detectSampleRate(uint16_t sampleCount)
+template <uint8_t NbInputs>
+eSampleRate cMixer<NbInputs>::detectSampleRate(double sampleRate) const
 {
-    // Detection with tolerance ±RX_BUFFER_SIZE
-    struct RateCheck
+    // Table of known sample rates
+    const eSampleRate rates[] =
     {
-        uint16_t delta;         // Expected delta value
-        eSampleRate rate;       // Corresponding sample rate
+        eSampleRate::SR96000,
+        eSampleRate::SR48000,
+        eSampleRate::SR44100,
+        eSampleRate::SR41000,
+        eSampleRate::SR32000
     };
 
-    // Table of known sample rates and their expected deltas
-    const RateCheck rates[] =
+    for (eSampleRate r : rates)
     {
-        {DELTA_DATE_96000, eSampleRate::SR96000},
-        {DELTA_DATE_48000, eSampleRate::SR48000},
-        {DELTA_DATE_44100, eSampleRate::SR44100},
-        {DELTA_DATE_41000, eSampleRate::SR41000},
-        {DELTA_DATE_32000, eSampleRate::SR32000}
-    };
-
-    // Check each rate against the received sample count
-    for (const auto& r : rates)
-    {
-        if (sampleCount < (r.delta + RX_BUFFER_SIZE) &&
-            sampleCount > (r.delta - RX_BUFFER_SIZE))
+        double nominal = getSampleRate(r);
+        if (std::fabs(sampleRate - nominal) < nominal * SYNC_RATE_TOLERANCE)
         {
-            return r.rate;
+            return r;
         }
     }
 
@@ -161,188 +1091,357 @@ eSampleRate cMixer::detectSampleRate(uint16_t sampleCount)
 }
 
 // -----------------------------------------------------------------------------
-// Updates buffer synchronization parameters based on detected sample rate
+// Updates synchronization parameters of an input
+// Called for each TX block. An input is synchronized while its DMA keeps
+// progressing (SYNC_TIMEOUT_MS) at a standard rate. The rate comes from the
+// position estimate as soon as it is valid, or from the rate reported by
+// the receiver before that, so audio starts within a few blocks instead
+// of waiting for a counting window.
 // -----------------------------------------------------------------------------
-void cMixer::updateBufferSync(
-    uint16_t& ctIN,               // Input sample counter
-    eSampleRate& currentRate,     // Current sample rate
-    float& nominalFactor,         // Nominal resampling factor
-    float& driftFactor,           // Current drift compensation factor
-    cCircularBuff& buffer,        // Circular buffer
-    double& dateOut               // Output date pointer
-)
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::updateBufferSync(uint8_t input)
 {
-    // Detect sample rate from input counter
-    eSampleRate detectedRate = detectSampleRate(ctIN);
-    ctIN = 0;  // Reset input counter
+    cRateEstimator& rate = m_RateIn[input];
+
+    // Input silent: drop the stale history
+    if (!m_Moving[input])
+    {
+        rate.Reset();
+        if (m_LockState[input] != eLockState::NoSync) stopInput(input);
+        return;
+    }
 
-    if (detectedRate != eSampleRate::NoSync)
+    double ratio = getMeasuredRatio(input);
+    if (ratio > 0.0)
     {
-        // If rate changed, update all parameters
-        if (detectedRate != currentRate)
+        // Measured rate: start, follow a rate change or stop on a non standard rate
+        eSampleRate detectedRate = detectSampleRate(ratio * OUTPUT_SAMPLE_RATE);
+        if (detectedRate == eSampleRate::NoSync)
+        {
+            if (m_LockState[input] != eLockState::NoSync) stopInput(input);
+        }
+        else if (detectedRate != m_SampleRate[input])
         {
-            currentRate = detectedRate;
-            nominalFactor = getSampleRate(detectedRate) / 48000.0f;  // Calculate resampling ratio
-            driftFactor = nominalFactor;                              // Initialize drift factor
-            buffer.setDate(0.0);                                      // Reset buffer date
-            dateOut = 0.0;                                            // Reset output date
+            startInput(input, detectedRate, ratio);
         }
     }
-    else
+    else if ((m_LockState[input] == eLockState::NoSync) && (m_BlockSourceRate[input] != 0))
     {
-        // No synchronization detected
-        driftFactor = 0.0f;
-        currentRate = eSampleRate::NoSync;
-        buffer.setDate(0.0);
-        dateOut = 0.0;
+        // Estimate not valid yet: start on the receiver rate
+        eSampleRate detectedRate = detectSampleRate(m_BlockSourceRate[input]);
+        if (detectedRate != eSampleRate::NoSync)
+        {
+            startInput(input, detectedRate, getSampleRate(detectedRate) / OUTPUT_SAMPLE_RATE);
+        }
     }
 }
 
 // -----------------------------------------------------------------------------
-// Adjusts drift compensation factor based on buffer fill level
+// Starts an input at a sample rate
+// The ring keeps receiving while the input is not synchronized, so it already
+// holds the target depth: the read position is placed so that the last frame
+// of the first block lies FILL_TARGET frames behind the estimated write
+// position and the ratio is seeded with the measure, the loop then has
+// nothing to pull in.
 // -----------------------------------------------------------------------------
-void cMixer::adjustDrift(
-    float& driftFactor,            // Current drift factor to adjust
-    float nominalFactor,           // Nominal resampling factor
-    const cCircularBuff& buffer,   // Circular buffer reference
-    double readDate                // Current read position
-)
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::startInput(uint8_t input, eSampleRate sr, double ratio)
 {
-    if (driftFactor == 0.0f) return;  // No adjustment if no sync
+    const cCircularBuff& buffer = m_Buffer[input];
 
-    // Calculate buffer fill level error
-    double age = buffer.getDate() - readDate;                // Current buffer age
-    double targetAge = static_cast<double>(RX_BUFFER_SIZE);  // Target buffer age
-    double error = (age - targetAge) / targetAge;            // Normalized error
+    m_SampleRate[input] = sr;
+    m_NominalFactor[input] = getSampleRate(sr) / OUTPUT_SAMPLE_RATE;  // Resampling ratio
+    m_DriftFactor[input] = ratio;                                      // Seeded drift factor
+    m_FeedForward[input] = ratio;
 
-    // Proportional adjustment based on error
-    double adjustment = 1.0 + error * m_gain;           // Apply gain to error
-    double factorTarget = nominalFactor * adjustment;   // Target factor
+    uint64_t writePhase = buffer.getPhase(0);
+    double age = FILL_TARGET + (TX_NB_FRAMES - 1) * ratio              // Target age from the write date
+               - getFillLevel(input, writePhase);
+    m_ReadPhase[input] = writePhase - static_cast<uint64_t>(age * PHASE_ONE);
 
-    // Clamp to ±50% of nominal factor
-    factorTarget = std::max(0.5 * nominalFactor,
-                            std::min(1.5 * nominalFactor, factorTarget));
+    resetLoop(input, eLockState::Acquire);
+    m_Starved[input] = false;
 
-    // Low-pass IIR filter to avoid artifacts
-    driftFactor = static_cast<float>(m_alpha * factorTarget +
-                                     (1.0 - m_alpha) * driftFactor);
+    // Receiver restart to first mixed block
+    if (m_Resyncing[input])
+    {
+        m_Resyncing[input] = false;
+        m_RecoveryCycles[input] = m_PullTimestamp - m_ResyncTimestamp[input];
+        if (m_RecoveryCycles[input] > m_RecoveryCyclesMax[input]) m_RecoveryCyclesMax[input] = m_RecoveryCycles[input];
+    }
 }
 
 // -----------------------------------------------------------------------------
-// Pushes samples into input buffer 1
+// Logs a stream event (audio task, single writer)
+// The slot is written before the count is published, the oldest event is
+// overwritten when the log is full.
 // -----------------------------------------------------------------------------
-void cMixer::pushSamples1(int32_t* pSamples)
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::logEvent(uint8_t input, eStreamEvent type, uint32_t timestamp, float fillLevel, uint32_t frames)
 {
-    // Process all samples in the buffer
-    for (int i = 0; i < RX_BUFFER_SIZE; i += 2)
-    {
-        BuffIn1.Push(pSamples);  // Push stereo pair
-        pSamples += 2;           // Move to next stereo pair
-        m_ctIN1++;               // Increment sample counter
-    }
+    uint32_t count = m_EventCount.load(std::memory_order_relaxed);
+    sStreamEvent& event = m_Event[count & (STREAM_EVENT_DEPTH - 1)];
+
+    event.Timestamp = timestamp;
+    event.OutDate = m_OutDate;
+    event.FillLevel = fillLevel;
+    event.LoopError = m_LoopError[input];
+    event.DriftFactor = static_cast<float>(m_DriftFactor[input]);
+    event.Frames = static_cast<uint16_t>(std::min<uint32_t>(frames, 0xFFFF));
+    event.Input = input;
+    event.Type = type;
+    event.LockState = m_LockState[input];
+
+    m_EventCount.store(count + 1, std::memory_order_release);
 }
 
 // -----------------------------------------------------------------------------
-// Pushes samples into input buffer 2
+// Copies a logged event (control side)
+// The audio task preempts the reader and logs whole events: the slot was not
+// rewritten during the copy when fewer than STREAM_EVENT_DEPTH events
+// followed it by then.
 // -----------------------------------------------------------------------------
-void cMixer::pushSamples2(int32_t* pSamples)
+template <uint8_t NbInputs>
+bool cMixer<NbInputs>::getEvent(uint32_t index, sStreamEvent& event) const
 {
-    // Process all samples in the buffer
-    for (int i = 0; i < RX_BUFFER_SIZE; i += 2)
-    {
-        BuffIn2.Push(pSamples);  // Push stereo pair
-        pSamples += 2;           // Move to next stereo pair
-        m_ctIN2++;               // Increment sample counter
-    }
+    uint32_t count = m_EventCount.load(std::memory_order_acquire);
+    if ((count - index - 1) >= STREAM_EVENT_DEPTH) return false;  // Not logged yet or overwritten
+
+    event = m_Event[index & (STREAM_EVENT_DEPTH - 1)];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (m_EventCount.load(std::memory_order_relaxed) - index) <= STREAM_EVENT_DEPTH;
+}
+
+// -----------------------------------------------------------------------------
+// Stops an input (no synchronization)
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::stopInput(uint8_t input)
+{
+    m_DriftFactor[input] = 0.0;
+    m_SampleRate[input] = eSampleRate::NoSync;
+    resetLoop(input, eLockState::NoSync);
+}
+
+// -----------------------------------------------------------------------------
+// Computes the loop coefficients of one mode for a bandwidth
+// Plant: the fill level integrates the ratio error, d(age)/dn = R - factor
+// with factor = nominal * (1 + correction). With correction = Kp.e + Ki.sum(e)
+// the closed loop is s^2 + nominal.Kp.s + nominal.Ki, so for a natural
+// frequency wn (rad per output frame): Kp = 2.zeta.wn, Ki = wn^2, the 1/nominal
+// term being applied in adjustDrift. The one pole error pre-filter attenuates
+// the fill level sawtooth caused by the RX and TX block sizes.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::setLoopGains(uint8_t mode, double bandwidthHz)
+{
+    const double twoPi = 6.283185307179586;
+    double wn = twoPi * bandwidthHz / OUTPUT_SAMPLE_RATE;
+
+    m_Kp[mode] = 2.0 * PLL_DAMPING * wn;
+    m_Ki[mode] = wn * wn;
+    m_Kf[mode] = 1.0 - std::exp(-twoPi * bandwidthHz * PLL_FILTER_RATIO / OUTPUT_SAMPLE_RATE);
 }
 
 // -----------------------------------------------------------------------------
-// Pushes samples into input buffer 3
+// Resets the drift control loop of an input
 // -----------------------------------------------------------------------------
-void cMixer::pushSamples3(int32_t* pSamples)
+template <uint8_t NbInputs>
+void cMixer<NbInputs>::resetLoop(uint8_t input, eLockState state)
 {
-    // Process all samples in the buffer
-    for (int i = 0; i < RX_BUFFER_SIZE; i += 2)
+    m_Integrator[input] = 0.0;
+    m_LoopError[input] = 0.0f;
+    m_LockCount[input] = 0;
+    m_LockState[input] = state;
+}
+
+// -----------------------------------------------------------------------------
+// Buffer fill level at the current TX callback
+// The write date captured from the DMA counter is the continuous write
+// position rounded down to a frame. The regression line of the captured
+// positions gives the continuous position at the TX timestamp, free of this
+// rounding and of the capture jitter. Until the estimate is valid the mean
+// lead of the continuous position over the write date (half a frame) is used.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE double cMixer<NbInputs>::getFillLevel(uint8_t input, uint64_t readPhase) const
+{
+    const cCircularBuff& buffer = m_Buffer[input];
+    double age = buffer.getAge(readPhase);
+
+    if (m_RateIn[input].isValid())
     {
-        BuffIn3.Push(pSamples);  // Push stereo pair
-        pSamples += 2;           // Move to next stereo pair
-        m_ctIN3++;               // Increment sample counter
+        age += m_RateIn[input].getOffset(m_PullTimestamp, buffer.getDate());
     }
+    else
+    {
+        age += 0.5;
+    }
+    return age;
 }
 
 // -----------------------------------------------------------------------------
-// Pulls mixed samples from all synchronized buffers
+// Runs the drift control loop of an input on the buffer fill level
+// Type-2 loop (PI controller) around the measured rate ratio: the last valid
+// ratio from the timestamps is the feed-forward term and the integral part
+// only holds what it misses (the source rate offset when the input started on
+// its nominal rate), so the fill level settles on FILL_TARGET whatever the
+// offset. The loop starts wide (Acquire) and narrows (Track) once the filtered
+// error has stayed within PLL_LOCK_ERROR for PLL_LOCK_TIME frames. Switching
+// keeps the integral part, so the ratio does not jump. Called once per block
+// of nbFrames.
 // -----------------------------------------------------------------------------
-void cMixer::pullSamples(int32_t* pSamples)
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::adjustDrift(
+    uint8_t input,                 // Input index
+    uint64_t readPhase,            // Current read position (32.32)
+    uint32_t nbFrames              // Frames elapsed since last adjustment
+)
 {
-    // Periodically detect and update sample rates
-    if (m_ctPull >= DRIF_CALC_NB_SAMPLES)
-    {
-        m_ctPull = 0;  // Reset pull counter
+    if (m_LockState[input] == eLockState::NoSync) return;  // No adjustment if no sync
 
-        // Update synchronization for all three inputs
-        updateBufferSync(m_ctIN1, m_SampleRate1, m_nominal_factor1,
-                        m_Drif_Factor1, BuffIn1, m_DateOut1);
-        updateBufferSync(m_ctIN2, m_SampleRate2, m_nominal_factor2,
-                        m_Drif_Factor2, BuffIn2, m_DateOut2);
-        updateBufferSync(m_ctIN3, m_SampleRate3, m_nominal_factor3,
-                        m_Drif_Factor3, BuffIn3, m_DateOut3);
-    }
+    const uint8_t mode = (m_LockState[input] == eLockState::Track) ? 1 : 0;
 
-    // Mix samples for the entire output buffer
-    for (int i = 0; i < TX_BUFFER_SIZE; i += 2)
+    // Feed-forward ratio, the measure is ignored when out of the loop range
+    // (estimate not settled after a source change)
+    const double nominalFactor = m_NominalFactor[input];
+    double measuredRatio = getMeasuredRatio(input);
+    if (std::fabs(measuredRatio - nominalFactor) < nominalFactor * PLL_MAX_DEVIATION)
     {
-        float sample1[2] = {0.0f, 0.0f};  // Buffer for input 1
-        float sample2[2] = {0.0f, 0.0f};  // Buffer for input 2
-        float sample3[2] = {0.0f, 0.0f};  // Buffer for input 3
+        m_FeedForward[input] = measuredRatio;
+    }
+    const double feedForward = m_FeedForward[input];
 
-        // Process input 1 if synchronized
-        if (m_Drif_Factor1 != 0.0f)
+    // Filtered fill level error (frames)
+    double error = getFillLevel(input, readPhase) - static_cast<double>(FILL_TARGET);
+    double loopError = m_LoopError[input];
+    loopError += (error - loopError) * m_Kf[mode] * nbFrames;
+    m_LoopError[input] = static_cast<float>(loopError);
+
+    // PI controller, relative ratio correction clamped to PLL_MAX_DEVIATION
+    double scaledError = loopError / feedForward;
+    double integrator = m_Integrator[input] + m_Ki[mode] * nbFrames * scaledError;
+    integrator = std::max(-PLL_MAX_DEVIATION, std::min(PLL_MAX_DEVIATION, integrator));
+    m_Integrator[input] = integrator;
+
+    double correction = integrator + m_Kp[mode] * scaledError;
+    correction = std::max(-PLL_MAX_DEVIATION, std::min(PLL_MAX_DEVIATION, correction));
+    m_DriftFactor[input] = feedForward * (1.0 + correction);
+
+    // Lock detection
+    if (m_LockState[input] == eLockState::Acquire)
+    {
+        if (std::fabs(loopError) < PLL_LOCK_ERROR)
         {
-            // Calculate read position with drift compensation
-            double readDate1 = (m_DateOut1 * m_Drif_Factor1) - RX_BUFFER_SIZE;
-            BuffIn1.Pull(sample1, readDate1);      // Pull samples from buffer
-            sample1[0] *= m_Gain1;                 // Apply channel gain
-            sample1[1] *= m_Gain1;
-            adjustDrift(m_Drif_Factor1, m_nominal_factor1, BuffIn1, readDate1);  // Adjust drift
+            m_LockCount[input] += nbFrames;
+            if (m_LockCount[input] >= PLL_LOCK_TIME)
+            {
+                m_LockState[input] = eLockState::Track;
+            }
         }
-
-        // Process input 2 if synchronized
-        if (m_Drif_Factor2 != 0.0f)
+        else
         {
-            // Calculate read position with drift compensation
-            double readDate2 = (m_DateOut2 * m_Drif_Factor2) - RX_BUFFER_SIZE;
-            BuffIn2.Pull(sample2, readDate2);      // Pull samples from buffer
-            sample2[0] *= m_Gain2;                 // Apply channel gain
-            sample2[1] *= m_Gain2;
-            adjustDrift(m_Drif_Factor2, m_nominal_factor2, BuffIn2, readDate2);  // Adjust drift
+            m_LockCount[input] = 0;
         }
+    }
+    else if (std::fabs(loopError) > PLL_UNLOCK_ERROR)
+    {
+        m_LockState[input] = eLockState::Acquire;
+        m_LockCount[input] = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Pulls one input block, applies its gain and accumulates into the mix
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::mixChannel(uint8_t input, float* pMix)
+{
+    if (m_LockState[input] == eLockState::NoSync) return;  // Input not synchronized
 
-        // Process input 3 if synchronized
-        if (m_Drif_Factor3 != 0.0f)
+    // Kernel selected by setInterpolation. Each kernel window ends on the
+    // frame following the read date, so the kernels delay the signal by
+    // different amounts (0 frame linear, 1 cubic, taps / 2 - 1 sinc): the
+    // output crossfades from the previous kernel instead of jumping. The read
+    // phase cannot absorb the difference, a longer kernel would need frames
+    // not received yet at the loop target age.
+    cCircularBuff& buffer = m_Buffer[input];
+    eInterpolation interp = m_Active.Interpolation[input];
+    if (buffer.getInterpolator() != interp)
+    {
+        m_FadeInterp[input] = buffer.getInterpolator();
+        m_FadeFrames[input] = 0;
+        buffer.setInterpolator(interp, getSincBank(interp));
+    }
+
+    // Read position advances by a constant 32.32 increment over the block
+    uint64_t increment = static_cast<uint64_t>(m_DriftFactor[input] * PHASE_ONE);
+
+    uint64_t readPhase = m_ReadPhase[input];
+    uint32_t underrun = buffer.getUnderrunFrames();
+    uint32_t overrun = buffer.getOverrunFrames();
+    buffer.PullBlock(m_BlockIn, m_ReadPhase[input], increment, TX_NB_FRAMES);
+
+    // Frames read out of the ring: one event at the start of a run of blocks
+    underrun = buffer.getUnderrunFrames() - underrun;
+    overrun = buffer.getOverrunFrames() - overrun;
+    if ((underrun | overrun) != 0)
+    {
+        if (!m_Starved[input])
         {
-            // Calculate read position with drift compensation
-            double readDate3 = (m_DateOut3 * m_Drif_Factor3) - RX_BUFFER_SIZE;
-            BuffIn3.Pull(sample3, readDate3);      // Pull samples from buffer
-            sample3[0] *= m_Gain3;                 // Apply channel gain
-            sample3[1] *= m_Gain3;
-            adjustDrift(m_Drif_Factor3, m_nominal_factor3, BuffIn3, readDate3);  // Adjust drift
+            m_Starved[input] = true;
+            eStreamEvent type = (underrun >= overrun) ? eStreamEvent::Underrun : eStreamEvent::Overrun;
+            if (type == eStreamEvent::Underrun) m_UnderrunCount[input]++;
+            else                                m_OverrunCount[input]++;
+            logEvent(input, type, m_PullTimestamp, buffer.getAge(readPhase), underrun + overrun);
         }
+    }
+    else
+    {
+        m_Starved[input] = false;
+        if (m_FadeFrames[input] < KERNEL_FADE_FRAMES) fadeKernel(input, readPhase, increment);
+    }
 
-        // Mix all channels and denormalize
-        pSamples[0] = static_cast<int32_t>((sample1[0] + sample2[0] + sample3[0]) * m_GainMaster * COEF_DENORMALIZE);
-        pSamples[1] = static_cast<int32_t>((sample1[1] + sample2[1] + sample3[1]) * m_GainMaster * COEF_DENORMALIZE);
+    float peak = VectorPeak(m_BlockIn, TX_BUFFER_SIZE);
+    if (peak > m_Peak[input]) m_Peak[input] = peak;
+    VectorScaleAdd(pMix, m_BlockIn, m_Active.Gain[input], TX_BUFFER_SIZE);
 
-        pSamples += 2;  // Move to next output stereo pair
+    // Drift update once per block, on the last read position
+    adjustDrift(input, m_ReadPhase[input] - increment, TX_NB_FRAMES);
+}
 
-        // Increment output dates and pull counter
-        m_DateOut1++;
-        m_DateOut2++;
-        m_DateOut3++;
-        m_ctPull++;
+// -----------------------------------------------------------------------------
+// Crossfades the block from the previous kernel to the selected one, the
+// weight of the new kernel rising linearly over KERNEL_FADE_FRAMES frames.
+// Both kernels read the same positions, the frames are already converted.
+// -----------------------------------------------------------------------------
+template <uint8_t NbInputs>
+ITCM_CODE void cMixer<NbInputs>::fadeKernel(uint8_t input, uint64_t readPhase, uint64_t increment)
+{
+    cCircularBuff& buffer = m_Buffer[input];
+    eInterpolation interp = buffer.getInterpolator();
+    eInterpolation fadeInterp = m_FadeInterp[input];
+
+    buffer.setInterpolator(fadeInterp, getSincBank(fadeInterp));
+    buffer.PullBlock(m_BlockFade, readPhase, increment, TX_NB_FRAMES);
+    buffer.setInterpolator(interp, getSincBank(interp));
+
+    constexpr float step = 1.0f / KERNEL_FADE_FRAMES;
+    uint32_t done = m_FadeFrames[input];
+    for (uint32_t i = 0; i < TX_NB_FRAMES; i++)
+    {
+        float weight = (done < KERNEL_FADE_FRAMES) ? (++done) * step : 1.0f;
+        m_BlockIn[i * 2]     = m_BlockFade[i * 2]     + (m_BlockIn[i * 2]     - m_BlockFade[i * 2])     * weight;
+        m_BlockIn[i * 2 + 1] = m_BlockFade[i * 2 + 1] + (m_BlockIn[i * 2 + 1] - m_BlockFade[i * 2 + 1]) * weight;
     }
+    m_FadeFrames[input] = done;
 }
 
+// -----------------------------------------------------------------------------
+// Firmware mixer instantiation
+// -----------------------------------------------------------------------------
+template class cMixer<MIXER_NB_INPUTS>;
+
 } // namespace Dad
 
 //***End of file**************************************************************
@@ -0,0 +1,133 @@
+//==================================================================================
+//==================================================================================
+// File: cPolyphaseSinc.cpp
+// Description: Polyphase windowed-sinc interpolator with precomputed coefficient
+//              banks (16/32/64 taps) used by cCircularBuff::Pull
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cPolyphaseSinc.h"
+#include <cmath>
+
+namespace Dad {
+
+// =============================================================================
+// Local helpers
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Zeroth order modified Bessel function (power series), used by Kaiser window
+// -----------------------------------------------------------------------------
+static double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x * 0.5;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= halfX / k;
+        sum += term * term;
+    }
+    return sum;
+}
+
+//**********************************************************************************
+// cPolyphaseSinc
+//**********************************************************************************
+
+// =============================================================================
+// Protected methods
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Computes all phases of the coefficient bank
+// Phase p covers fractional position p / SINC_NB_PHASES, the extra phase
+// SINC_NB_PHASES allows blending without wrap. Tap m weights the m-th frame
+// from the oldest one, the newest frame (m = nbTaps-1) being the one following
+// the integer read position, as for linear interpolation.
+// -----------------------------------------------------------------------------
+void cPolyphaseSinc::Build(float* pCoefs, uint16_t nbTaps, float cutoff, float beta)
+{
+    const double pi = 3.14159265358979323846;
+    const double halfWidth = nbTaps / 2.0;
+    const double normWindow = 1.0 / BesselI0(beta);
+
+    for (uint32_t p = 0; p <= SINC_NB_PHASES; p++)
+    {
+        double frac = static_cast<double>(p) / SINC_NB_PHASES;
+        float* pPhase = &pCoefs[p * nbTaps];
+        double sum = 0.0;
+
+        for (uint16_t m = 0; m < nbTaps; m++)
+        {
+            // Distance between interpolation point and sample m
+            double x = (halfWidth - 1.0 - m) + frac;
+
+            // Low-pass sinc
+            double arg = pi * cutoff * x;
+            double h = (x == 0.0) ? cutoff : cutoff * std::sin(arg) / arg;
+
+            // Kaiser window on [-halfWidth, halfWidth]
+            double r = x / halfWidth;
+            double w = (r * r < 1.0) ? BesselI0(beta * std::sqrt(1.0 - r * r)) * normWindow : 0.0;
+
+            pPhase[m] = static_cast<float>(h * w);
+            sum += h * w;
+        }
+
+        // Unity DC gain for every phase
+        float norm = static_cast<float>(1.0 / sum);
+        for (uint16_t m = 0; m < nbTaps; m++)
+        {
+            pPhase[m] *= norm;
+        }
+    }
+
+    m_pCoefs = pCoefs;
+    m_NbTaps = nbTaps;
+}
+
+// =============================================================================
+// Public methods
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Interpolates one stereo frame from contiguous interleaved frames
+// -----------------------------------------------------------------------------
+ITCM_CODE void cPolyphaseSinc::Interpolate(float* pSamples, const float* pFrames, float frac) const
+{
+    // Select the two surrounding phases and the blend factor
+    float phasePos = frac * SINC_NB_PHASES;
+    uint32_t phase = static_cast<uint32_t>(phasePos);
+    float blend = phasePos - phase;
+    if (phase >= SINC_NB_PHASES)        // frac rounded up to 1.0f
+    {
+        phase = SINC_NB_PHASES - 1;
+        blend = 1.0f;
+    }
+
+    const float* pCoefA = &m_pCoefs[phase * m_NbTaps];
+    const float* pCoefB = pCoefA + m_NbTaps;
+
+    float accAL = 0.0f, accAR = 0.0f;   // Phase p accumulators
+    float accBL = 0.0f, accBR = 0.0f;   // Phase p+1 accumulators
+
+    for (uint32_t m = 0; m < m_NbTaps; m++)
+    {
+        float sL = *pFrames++;
+        float sR = *pFrames++;
+        accAL += pCoefA[m] * sL;
+        accAR += pCoefA[m] * sR;
+        accBL += pCoefB[m] * sL;
+        accBR += pCoefB[m] * sR;
+    }
+
+    // Blend between phases
+    pSamples[0] = accAL + (accBL - accAL) * blend;
+    pSamples[1] = accAR + (accBR - accAR) * blend;
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -0,0 +1,99 @@
+//==================================================================================
+//==================================================================================
+// File: cRateEstimator.cpp
+// Description: Stream rate estimation from callback timestamps (exponentially
+//              weighted linear regression of frame position vs. CPU cycles)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cRateEstimator.h"
+#include <cmath>
+
+namespace Dad {
+
+// =============================================================================
+// Public methods
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Sets the time constant and the valid threshold
+// -----------------------------------------------------------------------------
+void cRateEstimator::Init(uint32_t window, uint32_t minPoints)
+{
+    m_Lambda = 1.0 - 1.0 / window;
+    m_MinPoints = minPoints;
+    Reset();
+}
+
+// -----------------------------------------------------------------------------
+// Clears the history
+// -----------------------------------------------------------------------------
+void cRateEstimator::Reset()
+{
+    m_Timestamp = 0;
+    m_Position = 0;
+    m_NbPoints = 0;
+    m_W = m_Sx = m_Sy = m_Sxx = m_Sxy = 0.0;
+    m_Slope = 0.0;
+    m_Intercept = 0.0;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a point and updates the fit
+// The origin moves to the new point: sums are translated by (-dx, -dy), aged
+// by the forgetting factor, then the new point (0, 0) adds only its weight.
+// -----------------------------------------------------------------------------
+ITCM_CODE void cRateEstimator::Update(uint32_t timestamp, uint32_t position)
+{
+    if (m_NbPoints == 0)
+    {
+        m_Timestamp = timestamp;
+        m_Position = position;
+        m_W = 1.0;
+        m_NbPoints = 1;
+        return;
+    }
+
+    double dx = static_cast<int32_t>(timestamp - m_Timestamp);
+    double dy = static_cast<int32_t>(position - m_Position);
+
+    // Point off the fit: restart from it
+    if (isValid() && std::fabs(dy - m_Intercept - m_Slope * dx) > RATE_EST_MAX_ERROR)
+    {
+        Reset();
+        Update(timestamp, position);
+        return;
+    }
+
+    m_Timestamp = timestamp;
+    m_Position = position;
+
+    // Translate to the new origin (uses the previous Sx, Sy)
+    double sx = m_Sx - dx * m_W;
+    double sy = m_Sy - dy * m_W;
+    m_Sxx = m_Sxx - 2.0 * dx * m_Sx + dx * dx * m_W;
+    m_Sxy = m_Sxy - dx * m_Sy - dy * m_Sx + dx * dy * m_W;
+    m_Sx = sx;
+    m_Sy = sy;
+
+    // Age the history and add the new point
+    m_W   = m_W * m_Lambda + 1.0;
+    m_Sx  *= m_Lambda;
+    m_Sy  *= m_Lambda;
+    m_Sxx *= m_Lambda;
+    m_Sxy *= m_Lambda;
+    if (m_NbPoints < m_MinPoints) m_NbPoints++;
+
+    // Weighted least squares fit
+    double det = m_W * m_Sxx - m_Sx * m_Sx;
+    if (det > 0.0)
+    {
+        m_Slope = (m_W * m_Sxy - m_Sx * m_Sy) / det;
+        m_Intercept = (m_Sy - m_Slope * m_Sx) / m_W;
+    }
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
@@ -7,7 +7,7 @@
 //***************************************************************************
 
 #include <cSPDIF_RX.h>
-#include <string.h>
+#include <cstring>
 
 namespace Dad {
 extern "C" {
@@ -29,25 +29,30 @@ TIM_HandleTypeDef* __phTIM6;
 // the reception and synchronization of S/PDIF data.
 //
 // pMixer - Mixer instance
+// Input - Mixer input fed by this receiver
+// pBuffer - Mixer input ring, target of the circular DMA
 // Freq_SPDiff_Clk - Input clock frequency for the S/PDIF peripheral
 //
-void cSPDIF_RX::Init(SPDIFRX_HandleTypeDef* phSPDIFRX, TIM_HandleTypeDef* phTIM, cMixer* pMixer, uint32_t Freq_SPDiff_Clk) {
+void cSPDIF_RX::Init(SPDIFRX_HandleTypeDef* phSPDIFRX, TIM_HandleTypeDef* phTIM, cAudioMixer* pMixer, uint8_t Input, int32_t* pBuffer, uint32_t Freq_SPDiff_Clk) {
     // Store the clock frequency for S/PDIF
     m_Freq_SPDiff_Clk = Freq_SPDiff_Clk;
 
     // Store the mixer instance
     m_pMixer = pMixer;
+    m_Input = Input;
+    m_pBuffer = pBuffer;
 
     // Link global timer handler to TIM6 (used for periodic interrupts)
     __phTIM6 = &m_hTIMMod.hTIM;
 
     // Initialize internal variables
-    m_CtCallBack = 0;           		// Reset the callback counter
     m_EtatSPDif = eEtatSPDif::inactive; // Initial state: inactive
     m_SPDiff_SampleRate = 0;    		// Reset the sample rate
 
-    // Initialize S/PDIF callbacks
-    cSPDIFRX_Handler::Init(phSPDIFRX);
+    // Initialize S/PDIF callbacks and attach the ring to the mixer input
+    cDeviceHandler::Init(phSPDIFRX);
+    std::memset(m_pBuffer, 0, CIRCULAR_BUFFER_SAMPLES * sizeof(int32_t));  // Silence
+    m_pMixer->attachInput(m_Input, m_pBuffer, this);
 
     // Initialize TIM callbacks and state machine
     cTIM_Handler::Init(phTIM);
@@ -71,6 +76,7 @@ void cSPDIF_RX::onPeriodElapsed() {
     switch (m_EtatSPDif) {
     // stop state
     case eEtatSPDif::stop:
+    	m_pMixer->setSourceRate(m_Input, 0);         	// Rate unknown
     	HAL_DMA_Abort_IT(m_phDevice->hdmaDrRx);      	// Abort DMA reception
         __HAL_SPDIFRX_IDLE(m_phDevice);              	// Set SPDIFRX to idle state
         m_EtatSPDif = eEtatSPDif::inactive;  			// Move to the inactive state
@@ -82,6 +88,7 @@ void cSPDIF_RX::onPeriodElapsed() {
 
     // Initialise state: Reset the S/PDIF receiver and prepare for synchronization
     case eEtatSPDif::init:
+    	m_pMixer->setSourceRate(m_Input, 0);         	// Rate unknown
     	HAL_DMA_Abort_IT(m_phDevice->hdmaDrRx);      	// Abort DMA reception
         __HAL_SPDIFRX_IDLE(m_phDevice);              	// Set SPDIFRX to idle state
         m_phDevice->State = HAL_SPDIFRX_STATE_READY; 	// Reset SPDIFRX state
@@ -92,11 +99,15 @@ void cSPDIF_RX::onPeriodElapsed() {
     // synchro state: Wait for synchronization with the incoming S/PDIF signal
     case eEtatSPDif::synchro: // synchro state: Wait for synchronization with the incoming S/PDIF signal
         if (__HAL_SPDIFRX_GET_FLAG(m_phDevice, SPDIFRX_FLAG_SYNCD)) {
-            // If synchronization is detected, start DMA reception
-            HAL_SPDIFRX_ReceiveDataFlow_DMA(m_phDevice, (uint32_t*)m_Buffer, RX_BUFFER_SIZE * 2);
+            // If synchronization is detected, start the circular DMA into
+            // the ring, the mixer reads its progress
+            HAL_SPDIFRX_ReceiveDataFlow_DMA(m_phDevice, (uint32_t*)m_pBuffer, CIRCULAR_BUFFER_SAMPLES);
+            BindRxDMA(m_phDevice->hdmaDrRx);        // DMA interrupt -> onReceive...
 
-            // Calculate the sample rate of the incoming S/PDIF stream
+            // Calculate the sample rate of the incoming S/PDIF stream and
+            // report it, the mixer starts the input on its first blocks
             CalcSampleRate();
+            m_pMixer->setSourceRate(m_Input, m_SPDiff_SampleRate);
 
             // Move to the run state to monitor the stream
             m_EtatSPDif = eEtatSPDif::run;
@@ -110,7 +121,9 @@ void cSPDIF_RX::onPeriodElapsed() {
     case eEtatSPDif::run:
         uint32_t Err = (m_phDevice->Instance->SR) & (SPDIFRX_FLAG_TERR | SPDIFRX_FLAG_FERR | SPDIFRX_FLAG_SERR);
         if (Err != 0) {
-            // If any error flags are set, reset to stop state
+            // If any error flags are set, restart the receiver, the mixer
+            // resynchronizes the input
+            m_pMixer->resyncInput(m_Input, CycleCounterGet());
             m_EtatSPDif = eEtatSPDif::init;
         }
         break;
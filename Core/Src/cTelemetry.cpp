@@ -0,0 +1,186 @@
+//==================================================================================
+//==================================================================================
+// File: cTelemetry.cpp
+// Description: Mixer telemetry frames over USB MIDI SysEx (main loop)
+//
+// Copyright (c) 2025 Dad Design.
+//==================================================================================
+//==================================================================================
+#include "cTelemetry.h"
+#include "usbd_midi_if.h"
+
+namespace Dad {
+
+// -----------------------------------------------------------------------------
+// Standard rate in Hz (0 = no sync)
+// -----------------------------------------------------------------------------
+static uint32_t SampleRateHz(eSampleRate sr)
+{
+    switch (sr)
+    {
+        case eSampleRate::SR32000: return 32000;
+        case eSampleRate::SR41000: return 41000;
+        case eSampleRate::SR44100: return 44100;
+        case eSampleRate::SR48000: return 48000;
+        case eSampleRate::SR96000: return 96000;
+        default:                   return 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Fixed point conversion (value * 2^shift, saturated to the int32_t range)
+// -----------------------------------------------------------------------------
+static uint32_t ToFixed(double value, uint32_t shift)
+{
+    double scaled = value * static_cast<double>(1UL << shift);
+    if (scaled >  2147483647.0) scaled =  2147483647.0;
+    if (scaled < -2147483648.0) scaled = -2147483648.0;
+    return static_cast<uint32_t>(static_cast<int32_t>(scaled));
+}
+
+// -----------------------------------------------------------------------------
+// Initializes with the start-up rate (frames per second, 0 = off)
+// -----------------------------------------------------------------------------
+void cTelemetry::Init(cAudioMixer* pMixer, uint8_t rate)
+{
+    m_pMixer   = pMixer;
+    m_LastSend = HAL_GetTick();
+    m_Sequence = 0;
+    m_Dropped  = 0;
+    m_EventRead = pMixer->getEventCount();
+    setRate(rate);
+}
+
+// -----------------------------------------------------------------------------
+// Frames per second (0 = off, clamped to TELEMETRY_MAX_RATE)
+// -----------------------------------------------------------------------------
+void cTelemetry::setRate(uint8_t rate)
+{
+    if (rate > TELEMETRY_MAX_RATE) rate = TELEMETRY_MAX_RATE;
+    m_Period = (rate == 0) ? 0 : 1000 / rate;
+}
+
+// -----------------------------------------------------------------------------
+// Main loop: sends a frame when its period elapsed, else the next event
+// The peaks are restarted after each frame sent, a dropped frame leaves them
+// to the next one.
+// -----------------------------------------------------------------------------
+void cTelemetry::Poll(uint32_t now)
+{
+    uint32_t period = m_Period;
+    if ((period == 0) || (m_pMixer == nullptr)) return;
+    if ((now - m_LastSend) < period)
+    {
+        sendEvent();
+        return;
+    }
+    m_LastSend = now;
+
+    uint8_t Frame[FRAME_SIZE];
+    uint16_t length = buildFrame(Frame);
+    m_Sequence++;
+
+    if (MIDI_SendSysEx(Frame, length) != USBD_OK)
+    {
+        m_Dropped++;           // Previous transfer pending or host not reading
+        return;
+    }
+    m_pMixer->resetPeaks();
+}
+
+// -----------------------------------------------------------------------------
+// Sends the next logged event, if the USB transfer is free
+// Events overwritten in the log before being sent are skipped (index gap).
+// -----------------------------------------------------------------------------
+void cTelemetry::sendEvent()
+{
+    uint32_t count = m_pMixer->getEventCount();
+    if (m_EventRead == count) return;
+    if ((count - m_EventRead) > STREAM_EVENT_DEPTH) m_EventRead = count - STREAM_EVENT_DEPTH;
+
+    sStreamEvent event;
+    if (!m_pMixer->getEvent(m_EventRead, event))
+    {
+        m_EventRead++;         // Overwritten during the copy
+        return;
+    }
+
+    uint8_t Frame[EVENT_SIZE];
+    uint8_t* pDst = Frame;
+    *pDst++ = 0xF0;
+    *pDst++ = SYSEX_ID;
+    *pDst++ = SYSEX_EVENT;
+    *pDst++ = VERSION;
+    *pDst++ = event.Input;
+    *pDst++ = static_cast<uint8_t>(event.Type);
+    *pDst++ = static_cast<uint8_t>(event.LockState);
+    pDst = MIDI_SysExPut32(pDst, m_EventRead);
+    pDst = MIDI_SysExPut32(pDst, event.Timestamp);
+    pDst = MIDI_SysExPut32(pDst, event.OutDate);
+    pDst = MIDI_SysExPut32(pDst, ToFixed(event.FillLevel, 8));
+    pDst = MIDI_SysExPut32(pDst, ToFixed(event.LoopError, 8));
+    pDst = MIDI_SysExPut32(pDst, ToFixed(event.DriftFactor, 28));
+    pDst = MIDI_SysExPut32(pDst, event.Frames);
+    *pDst++ = 0xF7;
+
+    if (MIDI_SendSysEx(Frame, pDst - Frame) == USBD_OK) m_EventRead++;
+}
+
+// -----------------------------------------------------------------------------
+// Builds one frame from the mixer getters, returns its length
+// The drift state (64-bit phase, double estimates) is not read as single
+// words: it comes from the set published by the latest mixed block, all the
+// inputs at the same block. Counters, peaks and loads are single words, each
+// coherent, read within the same main loop pass.
+// -----------------------------------------------------------------------------
+uint16_t cTelemetry::buildFrame(uint8_t* pFrame)
+{
+    m_pMixer->fetchStatus(m_Status);  // Keeps the previous set when no block was mixed
+    const cAudioMixer& mixer = *m_pMixer;
+    uint8_t* pDst = pFrame;
+
+    *pDst++ = 0xF0;
+    *pDst++ = SYSEX_ID;
+    *pDst++ = SYSEX_TELEMETRY;
+    *pDst++ = VERSION;
+    *pDst++ = cAudioMixer::NB_INPUTS;
+
+    const cCpuLoad& load = mixer.getCpuLoad();
+
+    pDst = MIDI_SysExPut32(pDst, m_Sequence);
+    pDst = MIDI_SysExPut32(pDst, mixer.getTxUnderrunCount());
+    pDst = MIDI_SysExPut32(pDst, mixer.getTxRequestOverflowCount());
+    pDst = MIDI_SysExPut32(pDst, mixer.getTxRestartCount());
+    pDst = MIDI_SysExPut32(pDst, load.getLoad());
+    pDst = MIDI_SysExPut32(pDst, load.getAverageLoad());
+    pDst = MIDI_SysExPut32(pDst, load.getPeakLoad());
+    pDst = MIDI_SysExPut32(pDst, load.getDeadlineMissCount());
+    pDst = MIDI_SysExPut32(pDst, load.getDeadlineUse());
+    pDst = MIDI_SysExPut32(pDst, ToFixed(mixer.getPeakOut(), 24));
+    pDst = MIDI_SysExPut32(pDst, mixer.getClipCount());
+
+    for (uint8_t input = 0; input < cAudioMixer::NB_INPUTS; input++)
+    {
+        const sInputStatus& status = m_Status.Input[input];
+        uint32_t rate = static_cast<uint32_t>(status.MeasuredRatio * OUTPUT_SAMPLE_RATE * 1000.0 + 0.5);
+
+        pDst = MIDI_SysExPut32(pDst, static_cast<uint32_t>(status.LockState));
+        pDst = MIDI_SysExPut32(pDst, SampleRateHz(mixer.GetSampleRate(input)));
+        pDst = MIDI_SysExPut32(pDst, rate);
+        pDst = MIDI_SysExPut32(pDst, ToFixed(status.DriftFactor, 28));
+        pDst = MIDI_SysExPut32(pDst, ToFixed(status.BufferAge, 8));
+        pDst = MIDI_SysExPut32(pDst, ToFixed(status.LoopError, 8));
+        pDst = MIDI_SysExPut32(pDst, mixer.getRxOverflowCount(input));
+        pDst = MIDI_SysExPut32(pDst, mixer.getResyncCount(input));
+        pDst = MIDI_SysExPut32(pDst, ToFixed(mixer.getPeak(input), 24));
+        pDst = MIDI_SysExPut32(pDst, mixer.getUnderrunCount(input));
+        pDst = MIDI_SysExPut32(pDst, mixer.getOverrunCount(input));
+    }
+
+    *pDst++ = 0xF7;
+    return static_cast<uint16_t>(pDst - pFrame);
+}
+
+} // namespace Dad
+
+//***End of file**************************************************************
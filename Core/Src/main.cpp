@@ -29,6 +29,13 @@
 #include "usbd_cdc_if.h"
 #include "W25Q128.h"
 #include "cFlashManager.h"
+#include "AudioTask.h"
+#include "cParamBlock.h"
+#include "Debug.h"
+#include "cTelemetry.h"
+#if CAPTURE_ENABLE
+#include "cCaptureFlash.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -63,10 +70,15 @@ DMA_HandleTypeDef hdma_spdif_rx_dt;
 TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN PV */
-int32_t __SAI_DIR9001_RX1_Buffer[40];
-int32_t __SAI_DIR9001_RX2_Buffer[40];
-
-Dad::cMixer 		  	__Mixer;
+// Mixer input rings and TX double buffer, accessed by the DMAs: D2 SRAM,
+// non-cacheable, so no cache maintenance is needed
+DMA_BUFFER int32_t __SAI_DIR9001_RX1_Buffer[CIRCULAR_BUFFER_SAMPLES];
+DMA_BUFFER int32_t __SAI_DIR9001_RX2_Buffer[CIRCULAR_BUFFER_SAMPLES];
+DMA_BUFFER int32_t __SPDIFRX_Buffer[CIRCULAR_BUFFER_SAMPLES];
+DMA_BUFFER int32_t __SAI_SPDIF_TX_Buffer[TX_BUFFER_SIZE * 2];
+
+// Mixer state (sinc banks, conversion caches, loops) in DTCM
+DTCM_DATA Dad::cAudioMixer __Mixer;
 Dad::cSAI_SPDIF_TX 	  	__SAI_SPDIF_TX;
 Dad::cSAI_DIR9001_RX1 	__SAI_DIR9001_RX1;
 Dad::cSAI_DIR9001_RX2 	__SAI_DIR9001_RX2;
@@ -75,8 +87,13 @@ Dad::cSPDIF_RX 		  	__SPDIFRX;
 DadDrivers::cW25Q128		__Flash;
 DadDrivers::cFlashManager 	__FlashManager;
 bool 						__FlashStatus = false;
-MemStruct					__MemStruct;
-bool						__MemStructChange = false;
+Dad::cParamBlock<MemStruct>	__MemStruct;		// Edited by OnControlChange (USB interrupt), saved by the main loop
+Dad::cTelemetry				__Telemetry;		// Mixer state frames, sent by the main loop
+#if CAPTURE_ENABLE
+uint8_t						__CaptureRing[CAPTURE_RAM_SIZE];	// AXI SRAM, filled by the audio task
+Dad::cCapture				__Capture;
+Dad::cCaptureFlash			__CaptureFlash;		// Ring to flash and dump, main loop
+#endif
 
 /* USER CODE END PV */
 
@@ -124,29 +141,52 @@ float midiToGain(uint8_t midiValue) {
 
 void OnControlChange(uint8_t channel, uint8_t control, uint8_t value){
 	if(control == CC_GAIN_1){
-		__MemStruct.vol1 = value;
-		__MemStructChange = true;
+		__MemStruct.Edit().vol1 = value;
+		__MemStruct.Publish();
 		float Gain =  midiToGain(value);
-		__Mixer.setGain1(Gain);
+		__Mixer.setGain(INPUT_RX1, Gain);
 	}
 	if(control == CC_GAIN_2){
-		__MemStruct.vol2 = value;
-		__MemStructChange = true;
+		__MemStruct.Edit().vol2 = value;
+		__MemStruct.Publish();
 		float Gain =  midiToGain(value);
-		__Mixer.setGain2(Gain);
+		__Mixer.setGain(INPUT_SPDIFRX, Gain);
 	}
 	if(control == CC_GAIN_3){
-		__MemStruct.vol3 = value;
-		__MemStructChange = true;
+		__MemStruct.Edit().vol3 = value;
+		__MemStruct.Publish();
 		float Gain =  midiToGain(value);
-		__Mixer.setGain3(Gain);
+		__Mixer.setGain(INPUT_RX2, Gain);
 	}
 	if(control == CC_GAIN_MASTER){
-		__MemStruct.volMaster = value;
-		__MemStructChange = true;
+		__MemStruct.Edit().volMaster = value;
+		__MemStruct.Publish();
 		float Gain =  midiToGain(value);
 		__Mixer.setGainMaster(Gain);
 	}
+	if((control == CC_INTERP_1) || (control == CC_INTERP_2) || (control == CC_INTERP_3)){
+		// Value is the kernel index (0 Linear, 1 Cubic, 2 Sinc16, 3 Sinc32, 4 Sinc64)
+		// Combinations over the CPU budget are refused by the mixer
+		if(value < Dad::NB_INTERPOLATIONS){
+			Dad::eInterpolation Interp = static_cast<Dad::eInterpolation>(value);
+			if(control == CC_INTERP_1) __Mixer.setInterpolation(INPUT_RX1, Interp);
+			if(control == CC_INTERP_2) __Mixer.setInterpolation(INPUT_SPDIFRX, Interp);
+			if(control == CC_INTERP_3) __Mixer.setInterpolation(INPUT_RX2, Interp);
+		}
+	}
+	if(control == CC_TELEMETRY){
+		__Telemetry.setRate(value);	// Frames per second, 0 = off
+	}
+#ifdef DEBUG
+	if(control == CC_PROFILE){
+		Profile_Request(value);		// Dump / clear from the main loop
+	}
+#endif
+#if CAPTURE_ENABLE
+	if(control == CC_CAPTURE){
+		__CaptureFlash.Request(value);	// Stop / dump / clear from the main loop
+	}
+#endif
 }
 
 void OnProgramChange(uint8_t channel, uint8_t program){
@@ -168,6 +208,16 @@ int main(void)
   /* MPU Configuration--------------------------------------------------------*/
   MPU_Config();
 
+  /* Enable the CPU Cache */
+#if CPU_CACHE_ENABLE
+
+  /* Enable I-Cache---------------------------------------------------------*/
+  SCB_EnableICache();
+
+  /* Enable D-Cache---------------------------------------------------------*/
+  SCB_EnableDCache();
+#endif
+
   /* MCU Configuration--------------------------------------------------------*/
 
   /* Configure The Vector Table address */
@@ -199,40 +249,64 @@ int main(void)
   MX_SAI3_Init();
   MX_QUADSPI_Init();
   MX_TIM6_Init();
-  MX_USB_DEVICE_Init();
   /* USER CODE BEGIN 2 */
   HAL_StatusTypeDef result = __Flash.Init(&hqspi, false, FLASH_ADR);
-  __MemStruct.vol1 = 113;
-  __MemStruct.vol2 = 113;
-  __MemStruct.vol3 = 113;
-  __MemStruct.volMaster = 113;
+  // Start-up values, not published: only the control changes are saved
+  MemStruct& Settings = __MemStruct.Edit();
+  Settings.vol1 = 113;
+  Settings.vol2 = 113;
+  Settings.vol3 = 113;
+  Settings.volMaster = 113;
   __Mixer.Initialise();
 
   if(result == HAL_OK){
 	  __FlashStatus = true;
 	  __FlashManager.Init(&__Flash, FLASH_ADR);
-	  if(false == __FlashManager.Load(&__MemStruct)){
+	  if(false == __FlashManager.Load(&Settings)){
 		  __FlashManager.EraseSectors();
-		  __FlashManager.Save(__MemStruct);
+		  __FlashManager.Save(Settings);
 	  }
-	  __Mixer.setGain1(midiToGain(__MemStruct.vol1));
-	  __Mixer.setGain2(midiToGain(__MemStruct.vol2));
-	  __Mixer.setGain3(midiToGain(__MemStruct.vol3));
-	  __Mixer.setGainMaster(midiToGain(__MemStruct.volMaster));
+	  __Mixer.setGain(INPUT_RX1, midiToGain(Settings.vol1));
+	  __Mixer.setGain(INPUT_SPDIFRX, midiToGain(Settings.vol2));
+	  __Mixer.setGain(INPUT_RX2, midiToGain(Settings.vol3));
+	  __Mixer.setGainMaster(midiToGain(Settings.volMaster));
   }
 
-  __SAI_DIR9001_RX1.Init(&hsai_BlockA2, &__Mixer, __SAI_DIR9001_RX1_Buffer);
-  __SAI_DIR9001_RX2.Init(&hsai_BlockA3, &__Mixer, __SAI_DIR9001_RX2_Buffer);
-  __SPDIFRX.Init(&hspdif1, &htim6, &__Mixer, 25000000);
-  __SAI_SPDIF_TX.Init(&hsai_BlockA1, &__Mixer);
+  __SAI_DIR9001_RX1.Init(&hsai_BlockA2, &__Mixer, INPUT_RX1, __SAI_DIR9001_RX1_Buffer);
+  __SAI_DIR9001_RX2.Init(&hsai_BlockA3, &__Mixer, INPUT_RX2, __SAI_DIR9001_RX2_Buffer);
+  __SPDIFRX.Init(&hspdif1, &htim6, &__Mixer, INPUT_SPDIFRX, __SPDIFRX_Buffer, 25000000);
+  __SAI_SPDIF_TX.Init(&hsai_BlockA1, &__Mixer, __SAI_SPDIF_TX_Buffer);
+  __Mixer.MeasureInterpolationCost();		// Needs the input rings, before the DMAs start
+#if CAPTURE_ENABLE
+  // Records from the first block, when the flash area holds no capture
+  if(__FlashStatus == true){
+	  __Capture.Init(__CaptureRing, CAPTURE_RAM_SIZE, CAPTURE_SAMPLE_MASK);
+	  if(__CaptureFlash.Init(&__Flash, &__Capture, FLASH_ADR + CAPTURE_FLASH_OFFSET, CAPTURE_FLASH_SIZE)){
+		  __Capture.Start();
+		  __Mixer.attachCapture(&__Capture);
+	  }
+  }
+#endif
+
+  Dad::AudioTaskInit();
+#ifdef DEBUG
+  Profile_Reset();
+#endif
 
   __SAI_DIR9001_RX1.StartReceive();
   __SAI_DIR9001_RX2.StartReceive();
   __SPDIFRX.StartReceive();
   __SAI_SPDIF_TX.StartTransmit();
+  __Telemetry.Init(&__Mixer, TELEMETRY_RATE);
+
+  // USB last (call not generated, see the .ioc): OnControlChange must be the
+  // only writer of the settings and mixer parameters, and its changes must
+  // not be overwritten by the start-up values or the flash settings
+  MX_USB_DEVICE_Init();
 
   uint8_t ctLed = 0;
   uint8_t ctFlash = 0;
+  uint32_t ledTick = HAL_GetTick();
 
   /* USER CODE END 2 */
 
@@ -243,7 +317,27 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-	  if(__Mixer.GetSampleRate3() != Dad::eSampleRate::NoSync){
+	  // Driver restarts, CPU load windows, telemetry and profiling at their own rate, LEDs
+	  // and settings save every 200 ms
+	  uint32_t now = HAL_GetTick();
+	  __SAI_SPDIF_TX.Poll();                  // DMA restarts after errors
+	  __SAI_DIR9001_RX1.Poll();
+	  __SAI_DIR9001_RX2.Poll();
+	  __Mixer.updateCpuLoad();
+	  __Telemetry.Poll(now);
+#ifdef DEBUG
+	  Profile_Poll();
+#endif
+#if CAPTURE_ENABLE
+	  __CaptureFlash.Poll();
+#endif
+	  if((now - ledTick) < 200){
+		  HAL_Delay(1);
+		  continue;
+	  }
+	  ledTick = now;
+
+	  if(__Mixer.GetSampleRate(INPUT_RX2) != Dad::eSampleRate::NoSync){
 		  HAL_GPIO_WritePin(LED3_GPIO_Port, LED3_Pin,  GPIO_PIN_RESET);
 	  }else{
 		  if(ctLed == 0){
@@ -253,7 +347,7 @@ int main(void)
 		  }
 	  }
 
-	  if(__Mixer.GetSampleRate2() != Dad::eSampleRate::NoSync){
+	  if(__Mixer.GetSampleRate(INPUT_SPDIFRX) != Dad::eSampleRate::NoSync){
 		  HAL_GPIO_WritePin(LED1_GPIO_Port, LED1_Pin,  GPIO_PIN_RESET);
 	  }else{
 		  if(ctLed == 3){
@@ -263,7 +357,7 @@ int main(void)
 		  }
 	  }
 
-	  if(__Mixer.GetSampleRate1() != Dad::eSampleRate::NoSync){
+	  if(__Mixer.GetSampleRate(INPUT_RX1) != Dad::eSampleRate::NoSync){
 		  HAL_GPIO_WritePin(LED2_GPIO_Port, LED2_Pin,  GPIO_PIN_RESET);
 	  }else{
 		  if(ctLed == 6){
@@ -278,14 +372,12 @@ int main(void)
 	  ctFlash++;
 	  if(ctFlash == 50){
 		  ctFlash = 0;
-		  if((__FlashStatus == true) && (__MemStructChange == true)){
-			  __disable_irq();
-			  __MemStructChange = false;
-			  __enable_irq();
-			  __FlashManager.Save(__MemStruct);
+		  // Last published settings, copied without masking the USB interrupt
+		  MemStruct Saved;
+		  if((__FlashStatus == true) && (__MemStruct.Fetch(Saved) == true)){
+			  __FlashManager.Save(Saved);
 		  }
 	  }
-	  HAL_Delay(200);
   }
   /* USER CODE END 3 */
 }
@@ -705,6 +797,13 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+//---------------------------------------------------------------------------
+// Audio task (PendSV, lowest priority): mixing requested by the TX callbacks
+extern "C" ITCM_CODE void AudioTask_Process(void){
+	PROFILE_START(Start);
+	__Mixer.Process();
+	PROFILE_STOP(Start, PROBE_AUDIO_TASK);
+}
 
 /* USER CODE END 4 */
 
@@ -755,6 +854,21 @@ void MPU_Config(void)
   MPU_InitStruct.AccessPermission = MPU_REGION_PRIV_RO_URO;
   MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
 
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  /** Initializes and configures the Region and the memory to be protected
+  */
+  MPU_InitStruct.Number = MPU_REGION_NUMBER3;
+  MPU_InitStruct.BaseAddress = 0x30000000;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_512KB;
+  MPU_InitStruct.SubRegionDisable = 0x0;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+
   HAL_MPU_ConfigRegion(&MPU_InitStruct);
   /* Enables the MPU */
   HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
@@ -1,175 +1,219 @@
 //******************************************************************************
 // cDeviceHandler.h
 //
-// This file defines a class to handle device with callback mechanisms.
+// This file defines a class template to handle device with callback
+// mechanisms, resolved at compile time (CRTP).
 //
 //******************************************************************************
 
 #ifndef CDEVICE_HANDLER_H_
 #define CDEVICE_HANDLER_H_
 
-#define DECLARE_DEVICE_HANDLE(DeviceTypeDef, ClassName, CallbackName)\
-/*****************************************************************************/\
-/* This class provides a framework for handling device communication using the HAL library.*/\
-/* It includes callback mechanisms to be implemented by derived classes.*/\
-\
-class CallbackName##Handler {\
-public:\
-    /*---------------------------------------------------------------------*/\
-    /* Constructor Destructor*/\
-\
-	CallbackName##Handler(){}\
-    ~CallbackName##Handler(){}\
- \
-	/*-----------------------------------------------------------------------*/\
-    /* Init method*/\
-    /* This method initializes the instance*/ \
-    /* and registering various devices callbacks.*/\
-\
-    void Init(DeviceTypeDef* phDevice){\
-    	m_phDevice = phDevice;\
-    	m_pThis = this;\
-\
-    	/* Register the receive complete callback*/\
-    	phDevice->RxCpltCallback = ReceiveCompleteCallback;\
-\
-    	/* Register the half receive complete callback*/\
-    	phDevice->RxHalfCpltCallback = ReceiveHalfCompleteCallback;\
-\
-    	/* Register the transmit complete callback*/\
-    	phDevice->TxCpltCallback = TransmitCompleteCallback;\
-\
-    	/* Register the half transmit complete callback*/\
-    	phDevice->TxHalfCpltCallback = TransmitHalfCompleteCallback;\
-\
-    	/* Register the error callback*/\
-    	phDevice->ErrorCallback = ErrorCallback;\
-    }\
-\
-protected:\
-    /*-----------------------------------------------------------------------*/\
-    /* Member Variables*/\
-\
-	DeviceTypeDef*	m_phDevice;\
-	static CallbackName##Handler* m_pThis;\
-\
-    /*--------------------------------------------------------------------*/\
-    /* Static callback functions called by HAL.*/\
-    /* These functions are static because the HAL library doesn't know which instance*/\
-    /* of cDevice_Handler to call. We manually redirect the callback to the correct instance.*/\
-\
-    static void ReceiveCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onReceiveComplete_##CallbackName();\
-    }\
-\
-    static void ReceiveHalfCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onReceiveHalfComplete_##CallbackName();\
-    }\
-\
-    static void TransmitCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onTransmitComplete_##CallbackName();\
-    }\
-\
-    static void TransmitHalfCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onTransmitHalfComplete_##CallbackName();\
-    }\
-    static void ErrorCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onErrorCallback_##CallbackName();\
-    }\
-\
-    /*---------------------------------------------------------------------*/\
-    /* Virtual methods for derived classes to override.*/\
-    /* These are meant to define custom behavior when a callback occurs.*/\
-\
-    virtual void onReceiveComplete_##CallbackName() {}\
-\
-    virtual void onReceiveHalfComplete_##CallbackName() {}\
-\
-    virtual void onTransmitComplete_##CallbackName() {}\
-\
-    virtual void onTransmitHalfComplete_##CallbackName() {}\
-\
-    virtual void onErrorCallback_##CallbackName() {\
-        /* Default error handling: infinite loop. Can be overridden by derived classes.*/\
-        while(1);\
-    }\
-};\
-typedef Dad::CallbackName##Handler ClassName;
-
-#define INSTANTIATE_DEVICE_HANDLE(ClassName) ClassName* ClassName::m_pThis = nullptr;
-
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-#define DECLARE_DEVICE_RXHANDLE(DeviceTypeDef, ClassName, CallbackName)\
-/*****************************************************************************/\
-/* This class provides a framework for handling device communication using the HAL library.*/\
-/* It includes callback mechanisms to be implemented by derived classes.*/\
-\
-class CallbackName##RxHandler {\
-public:\
-    /*---------------------------------------------------------------------*/\
-    /* Constructor Destructor*/\
-\
-	CallbackName##RxHandler(){}\
-    ~CallbackName##RxHandler(){}\
- \
-	/*-----------------------------------------------------------------------*/\
-    /* Init method*/\
-    /* This method initializes the instance*/ \
-    /* and registering various devices callbacks.*/\
-\
-    void Init(DeviceTypeDef* phDevice){\
-    	m_phDevice = phDevice;\
-    	m_pThis = this;\
-\
-    	/* Register the receive complete callback*/\
-    	phDevice->RxCpltCallback = ReceiveCompleteCallback;\
-\
-    	/* Register the half receive complete callback*/\
-    	phDevice->RxHalfCpltCallback = ReceiveHalfCompleteCallback;\
-\
-    	/* Register the error callback*/\
-    	phDevice->ErrorCallback = ErrorCallback;\
-    }\
-\
-protected:\
-    /*-----------------------------------------------------------------------*/\
-    /* Member Variables*/\
-\
-	DeviceTypeDef*	m_phDevice;\
-	static CallbackName##RxHandler* m_pThis;\
-\
-    /*--------------------------------------------------------------------*/\
-    /* Static callback functions called by HAL.*/\
-    /* These functions are static because the HAL library doesn't know which instance*/\
-    /* of cDevice_Handler to call. We manually redirect the callback to the correct instance.*/\
-\
-    static void ReceiveCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onReceiveComplete_##CallbackName();\
-    }\
-\
-    static void ReceiveHalfCompleteCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onReceiveHalfComplete_##CallbackName();\
-    }\
-\
-	static void ErrorCallback(DeviceTypeDef* phDevice) {\
-    	m_pThis->onErrorCallback_##CallbackName();\
-    }\
-\
-    /*---------------------------------------------------------------------*/\
-    /* Virtual methods for derived classes to override.*/\
-    /* These are meant to define custom behavior when a callback occurs.*/\
-\
-    virtual void onReceiveComplete_##CallbackName() {}\
-\
-    virtual void onReceiveHalfComplete_##CallbackName() {}\
-\
-    virtual void onErrorCallback_##CallbackName() {\
-        /* Default error handling: infinite loop. Can be overridden by derived classes.*/\
-        while(1);\
-    }\
-};\
-typedef CallbackName##RxHandler ClassName;\
-
-#define INSTANTIATE_DEVICE_RXHANDLE(ClassName) ClassName* ClassName::m_pThis = nullptr;
+#include "main.h"
+#include <cstdint>
+#include <type_traits>
+
+namespace Dad {
+
+//******************************************************************************
+// Class cDeviceHandler
+//
+// This class provides a framework for handling device communication using the
+// HAL library. Derived is the driver class (class cDriver : public
+// cDeviceHandler<cDriver, SAI_HandleTypeDef>): the static callbacks call its
+// methods directly, without virtual call, so the driver callback is inlined
+// in them.
+//
+// Derived is the dispatch key: each instantiation has its own instance
+// pointer, so one object per Derived type. Several instances of one peripheral
+// type are instantiations of a driver class template on a key parameter (pin
+// set traits, instance index: cSAI_DIR9001_RX<sDIR9001_Pins1>), sharing this
+// code without one declaration per instance. Init of a second object of the
+// same Derived type is a configuration error (Error_Handler).
+//
+// Derived hides the on... methods it handles and declares this class as
+// friend when they are not public.
+//
+// Tx = false for receive only devices (no transmit callbacks in the handle).
+//
+// The error callbacks run in the DMA interrupt, above SysTick: the HAL abort
+// and start functions, whose timeouts count HAL_GetTick, could spin there
+// forever. A driver restarts its transfer from the main loop instead:
+// onDeviceError calls requestRestart, Poll (main loop) then calls onRestart.
+//
+//******************************************************************************
+template <class Derived, typename DeviceTypeDef, bool Tx = true>
+class cDeviceHandler {
+public:
+    //---------------------------------------------------------------------
+    // Constructor Destructor
+
+    cDeviceHandler() : m_phDevice(nullptr), m_ErrorCount(0), m_RestartRequest(0), m_RestartHandled(0) {}
+    ~cDeviceHandler(){}
+
+    //-----------------------------------------------------------------------
+    // Init method
+    // This method initializes the instance
+    // and registering various devices callbacks.
+
+    void Init(DeviceTypeDef* phDevice){
+    	if ((m_pInstance != nullptr) && (m_pInstance != static_cast<Derived*>(this))) {
+    		Error_Handler();               // Callbacks already bound to another object
+    	}
+    	m_phDevice = phDevice;
+    	m_pInstance = static_cast<Derived*>(this);
+
+    	// Register the receive complete callback
+    	phDevice->RxCpltCallback = ReceiveCompleteCallback;
+
+    	// Register the half receive complete callback
+    	phDevice->RxHalfCpltCallback = ReceiveHalfCompleteCallback;
+
+    	// Register the transmit callbacks
+    	RegisterTx(phDevice, std::integral_constant<bool, Tx>());
+
+    	// Register the error callback
+    	phDevice->ErrorCallback = ErrorCallback;
+    }
+
+    //-----------------------------------------------------------------------
+    // Number of error callbacks received
+
+    uint32_t getErrorCount() const { return m_ErrorCount; }
+
+    //-----------------------------------------------------------------------
+    // Main loop: runs the restart requested by the error callbacks (once for
+    // several requests, a request arriving during onRestart runs it again)
+
+    void Poll() {
+    	uint32_t request = m_RestartRequest;
+    	if (request != m_RestartHandled) {
+    		m_RestartHandled = request;
+    		static_cast<Derived*>(this)->onRestart();
+    	}
+    }
+
+protected:
+    //-----------------------------------------------------------------------
+    // Member Variables
+
+	DeviceTypeDef*	m_phDevice;
+	volatile uint32_t m_ErrorCount;
+	static Derived* m_pInstance;       // One per Derived instantiation (dispatch key)
+	volatile uint32_t m_RestartRequest; // Restarts requested (error callbacks)
+	uint32_t m_RestartHandled;         // Restarts run (main loop)
+
+    //-----------------------------------------------------------------------
+    // Error callback side: the main loop restarts the transfer (Poll)
+
+    void requestRestart() {
+    	m_RestartRequest = m_RestartRequest + 1;
+    }
+
+    //-----------------------------------------------------------------------
+    // Binds a circular DMA stream to the callbacks, after each HAL start
+    // (the HAL start functions set the DMA callbacks to their own handlers).
+    // In circular mode the HAL device handlers only forward the call through
+    // the device handle: the DMA interrupt then calls the driver directly.
+    // The device level callbacks stay registered and call the same methods.
+
+    void BindRxDMA(DMA_HandleTypeDef* phDMA) {
+    	phDMA->XferCpltCallback = DMAReceiveCompleteCallback;
+    	phDMA->XferHalfCpltCallback = DMAReceiveHalfCompleteCallback;
+    }
+
+    void BindTxDMA(DMA_HandleTypeDef* phDMA) {
+    	phDMA->XferCpltCallback = DMATransmitCompleteCallback;
+    	phDMA->XferHalfCpltCallback = DMATransmitHalfCompleteCallback;
+    }
+
+    //--------------------------------------------------------------------
+    // Static callback functions called by HAL.
+    // These functions are static because the HAL library doesn't know which instance
+    // of the driver to call: each Derived instantiation has its own functions,
+    // reading its own m_pInstance (set by Init) before a direct, inlined call.
+
+    ITCM_CODE static void ReceiveCompleteCallback(DeviceTypeDef* phDevice) {
+    	m_pInstance->onReceiveComplete();
+    }
+
+    ITCM_CODE static void ReceiveHalfCompleteCallback(DeviceTypeDef* phDevice) {
+    	m_pInstance->onReceiveHalfComplete();
+    }
+
+    ITCM_CODE static void TransmitCompleteCallback(DeviceTypeDef* phDevice) {
+    	m_pInstance->onTransmitComplete();
+    }
+
+    ITCM_CODE static void TransmitHalfCompleteCallback(DeviceTypeDef* phDevice) {
+    	m_pInstance->onTransmitHalfComplete();
+    }
+
+    static void ErrorCallback(DeviceTypeDef* phDevice) {
+    	static_cast<cDeviceHandler*>(m_pInstance)->m_ErrorCount++;
+    	m_pInstance->onDeviceError();
+    }
+
+    //--------------------------------------------------------------------
+    // Static callback functions called by the DMA interrupt (BindRxDMA /
+    // BindTxDMA).
+
+    ITCM_CODE static void DMAReceiveCompleteCallback(DMA_HandleTypeDef* phDMA) {
+    	m_pInstance->onReceiveComplete();
+    }
+
+    ITCM_CODE static void DMAReceiveHalfCompleteCallback(DMA_HandleTypeDef* phDMA) {
+    	m_pInstance->onReceiveHalfComplete();
+    }
+
+    ITCM_CODE static void DMATransmitCompleteCallback(DMA_HandleTypeDef* phDMA) {
+    	m_pInstance->onTransmitComplete();
+    }
+
+    ITCM_CODE static void DMATransmitHalfCompleteCallback(DMA_HandleTypeDef* phDMA) {
+    	m_pInstance->onTransmitHalfComplete();
+    }
+
+    //---------------------------------------------------------------------
+    // Default methods, hidden by the derived class methods of the same name.
+    // These are meant to define custom behavior when a callback occurs.
+
+    void onReceiveComplete() {}
+
+    void onReceiveHalfComplete() {}
+
+    void onTransmitComplete() {}
+
+    void onTransmitHalfComplete() {}
+
+    void onDeviceError() {
+        // Default error handling: the error is only counted. The HAL has
+        // already stopped the transfer, derived classes restart it.
+    }
+
+    void onRestart() {}
+
+private:
+    //---------------------------------------------------------------------
+    // Transmit callbacks registration (devices with transmit callbacks only)
+
+    static void RegisterTx(DeviceTypeDef* phDevice, std::true_type) {
+    	phDevice->TxCpltCallback = TransmitCompleteCallback;
+    	phDevice->TxHalfCpltCallback = TransmitHalfCompleteCallback;
+    }
+
+    static void RegisterTx(DeviceTypeDef*, std::false_type) {}
+};
+
+template <class Derived, typename DeviceTypeDef, bool Tx>
+Derived* cDeviceHandler<Derived, DeviceTypeDef, Tx>::m_pInstance = nullptr;
+
+//******************************************************************************
+// Receive only devices
+
+template <class Derived, typename DeviceTypeDef>
+using cDeviceRxHandler = cDeviceHandler<Derived, DeviceTypeDef, false>;
+
+} /* namespace Dad */
 
 #endif /* CDEVICE_HANDLER_H_ */
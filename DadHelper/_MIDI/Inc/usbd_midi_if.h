@@ -26,11 +26,15 @@ extern "C" {
 
 extern USBD_MIDI_ItfTypeDef USBD_MIDI_fops;  // MIDI interface callbacks
 
+#define MIDI_TX_BUFFER_SIZE         512U  // Transmit buffer (several USB packets per transfer)
+
 //**********************************************************************************
 // Exported functions
 //**********************************************************************************
 
 uint8_t MIDI_Transmit(uint8_t *buffer, uint16_t length);  // Transmit MIDI data over USB
+uint8_t MIDI_SendSysEx(const uint8_t *data, uint16_t length);  // Transmit a SysEx message (non blocking)
+uint8_t *MIDI_SysExPut32(uint8_t *dst, uint32_t value);        // Append a 32-bit value as 5 SysEx data bytes
 
 // =============================================================================
 // MIDI USB Code Index Numbers (CIN) definitions
@@ -20,7 +20,7 @@ extern USBD_HandleTypeDef hUsbMidiDeviceFS;  // USB device handle
 //**********************************************************************************
 
 static uint8_t UserRxBuffer[MIDI_DATA_FS_MAX_PACKET_SIZE];  // Receive buffer for MIDI data
-static uint8_t UserTxBuffer[MIDI_DATA_FS_MAX_PACKET_SIZE];  // Transmit buffer for MIDI data
+static uint8_t UserTxBuffer[MIDI_TX_BUFFER_SIZE];           // Transmit buffer for MIDI data (multi packet transfers)
 
 //**********************************************************************************
 // Private function prototypes
@@ -148,7 +148,7 @@ static int8_t MIDI_Receive_FS(uint8_t *Buf, uint32_t Len)
 
 // Transmit MIDI data over USB
 // buffer: Buffer of data to transmit
-// length: Number of data to transmit (must be multiple of 4)
+// length: Number of data to transmit (must be multiple of 4, up to MIDI_TX_BUFFER_SIZE)
 // Returns: USBD_OK if all operations are OK else USBD_FAIL or USBD_BUSY
 uint8_t MIDI_Transmit(uint8_t *buffer, uint16_t length)
 {
@@ -156,7 +156,7 @@ uint8_t MIDI_Transmit(uint8_t *buffer, uint16_t length)
     USBD_MIDI_HandleTypeDef *hmidi = (USBD_MIDI_HandleTypeDef *)hUsbMidiDeviceFS.pClassData;
 
     // Check if MIDI handle is valid
-    if (hmidi == NULL)
+    if ((hmidi == NULL) || (length > MIDI_TX_BUFFER_SIZE))
     {
         return USBD_FAIL;
     }
@@ -180,6 +180,74 @@ uint8_t MIDI_Transmit(uint8_t *buffer, uint16_t length)
     return result;
 }
 
+// -----------------------------------------------------------------------------
+// MIDI_SendSysEx: Send a System Exclusive message
+// -----------------------------------------------------------------------------
+
+// Send a System Exclusive message, packed into USB MIDI event packets and
+// sent as a single transfer. Does not wait: returns USBD_BUSY while the
+// previous transfer is in progress, the caller sends it again later.
+// data: Message from F0 to F7 included (data bytes 0-127)
+// length: Message length (up to MIDI_TX_BUFFER_SIZE * 3 / 4 bytes)
+// Returns: USBD_OK, USBD_BUSY or USBD_FAIL
+uint8_t MIDI_SendSysEx(const uint8_t *data, uint16_t length)
+{
+    USBD_MIDI_HandleTypeDef *hmidi = (USBD_MIDI_HandleTypeDef *)hUsbMidiDeviceFS.pClassData;
+
+    if ((hmidi == NULL) || (length < 2) || (((length + 2) / 3) * 4 > MIDI_TX_BUFFER_SIZE))
+    {
+        return USBD_FAIL;
+    }
+    if (hmidi->txState != 0)
+    {
+        return USBD_BUSY;
+    }
+
+    // 3 bytes per packet, the last one tells how many bytes end the message
+    uint16_t size = 0;
+    for (uint16_t i = 0; i < length; i += 3)
+    {
+        uint16_t left = length - i;
+        uint8_t *packet = &UserTxBuffer[size];
+        if (left > 3)
+        {
+            packet[0] = (0 << 4) | MIDI_CIN_SYSEX_START;   // Cable 0 + CIN
+            packet[1] = data[i];
+            packet[2] = data[i + 1];
+            packet[3] = data[i + 2];
+        }
+        else
+        {
+            packet[0] = (0 << 4) | (MIDI_CIN_SYSEX_END_1BYTE + left - 1);
+            packet[1] = data[i];
+            packet[2] = (left > 1) ? data[i + 1] : 0;
+            packet[3] = (left > 2) ? data[i + 2] : 0;
+        }
+        size += 4;
+    }
+
+    USBD_MIDI_SetTxBuffer(&hUsbMidiDeviceFS, UserTxBuffer, size);
+    return USBD_LL_Transmit(&hUsbMidiDeviceFS, MIDI_IN_EP, UserTxBuffer, size);
+}
+
+// -----------------------------------------------------------------------------
+// MIDI_SysExPut32: Append a 32-bit value to a SysEx message
+// -----------------------------------------------------------------------------
+
+// Append a 32-bit value as 5 data bytes of 7 bits, least significant first
+// dst: Write position in the message
+// value: Value (signed values as two's complement)
+// Returns: Write position after the value
+uint8_t *MIDI_SysExPut32(uint8_t *dst, uint32_t value)
+{
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        *dst++ = value & 0x7F;
+        value >>= 7;
+    }
+    return dst;
+}
+
 // -----------------------------------------------------------------------------
 // MIDI_SendNoteOn: Send MIDI Note On message
 // -----------------------------------------------------------------------------
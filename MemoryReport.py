@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#==================================================================================
+#==================================================================================
+# File: MemoryReport.py
+# Description: Build time report of the tightly coupled memory placement
+#
+#   python MemoryReport.py <project>.map [--strict]
+#
+# Reads the GNU ld map file and lists what was linked in ITCM (.itcm_text),
+# DTCM (.DTCMRAM_Section) and D2 SRAM (.RAM_D2_Section), with the region
+# usage. The interrupt path is selected by name in the linker script: a
+# renamed HAL function silently falls back to flash, so the handlers below
+# are checked and reported when missing (--strict makes it a build error).
+#
+# Run as the post-build step of the STM32CubeIDE configurations.
+#
+# Copyright (c) 2025 Dad Design.
+#==================================================================================
+#==================================================================================
+import re
+import sys
+
+# Output section -> memory region
+SECTIONS = {
+    '.itcm_text':       'ITCMRAM',
+    '.DTCMRAM_Section': 'DTCMRAM',
+    '.RAM_D2_Section':  'RAM_D2',
+}
+
+# Functions expected in ITCM (interrupt and audio task path)
+ITCM_EXPECTED = [
+    'PendSV_Handler',
+    'DMA1_Stream0_IRQHandler', 'DMA1_Stream1_IRQHandler',
+    'DMA1_Stream2_IRQHandler', 'DMA1_Stream3_IRQHandler',
+    'HAL_DMA_IRQHandler',
+    'SAI_DMATxCplt', 'SAI_DMATxHalfCplt', 'SAI_DMARxCplt', 'SAI_DMARxHalfCplt',
+    'SPDIFRX_DMARxCplt', 'SPDIFRX_DMARxHalfCplt',
+    'AudioTask_Process',
+]
+
+RE_REGION  = re.compile(r'^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+RE_OUTPUT  = re.compile(r'^(\.\S+)\s*(?:0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+RE_INPUT   = re.compile(r'^ (\.\S+|COMMON)\s*(?:0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$')
+RE_CONT    = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+RE_SYMBOL  = re.compile(r'^\s+0x([0-9a-fA-F]+)\s{2,}([^=]+)$')
+
+
+# -----------------------------------------------------------------------------
+# Parses the map file: memory regions and the input sections of SECTIONS
+# -----------------------------------------------------------------------------
+def ParseMap(path):
+    regions = {}
+    sections = {name: {'size': 0, 'inputs': []} for name in SECTIONS}
+
+    with open(path, 'r', errors='replace') as f:
+        lines = f.read().splitlines()
+
+    state = None       # 'memory', 'map'
+    current = None     # Output section being read (one of SECTIONS)
+    pending = None     # Input section whose address is on the next line
+    for line in lines:
+        if line.startswith('Memory Configuration'):
+            state = 'memory'
+            continue
+        if line.startswith('Linker script and memory map'):
+            state = 'map'
+            continue
+
+        if state == 'memory':
+            m = RE_REGION.match(line)
+            if m:
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+            continue
+        if state != 'map' or not line.strip():
+            continue
+
+        # Output section header (column 0)
+        if not line[0].isspace():
+            m = RE_OUTPUT.match(line)
+            current = m.group(1) if m and m.group(1) in SECTIONS else None
+            if current and m.group(3):
+                sections[current]['size'] = int(m.group(3), 16)
+            pending = None
+            continue
+        if current is None:
+            continue
+
+        # Input section, address / size / object on the same or the next line
+        m = RE_INPUT.match(line)
+        if m:
+            if m.group(2):
+                AddInput(sections[current], m.group(1), m.group(2), m.group(3), m.group(4))
+                pending = None
+            else:
+                pending = m.group(1)
+            continue
+        m = RE_CONT.match(line)
+        if m and pending:
+            AddInput(sections[current], pending, m.group(1), m.group(2), m.group(3))
+            pending = None
+            continue
+
+        # Symbol of the last input section
+        m = RE_SYMBOL.match(line)
+        if m and sections[current]['inputs']:
+            sections[current]['inputs'][-1]['symbols'].append(m.group(2).strip())
+
+    # Header size may be on a continuation line: fall back to the inputs sum
+    for sec in sections.values():
+        if sec['size'] == 0:
+            sec['size'] = sum(i['size'] for i in sec['inputs'])
+    return regions, sections
+
+
+# -----------------------------------------------------------------------------
+# Records one input section (zero sized fill entries are ignored)
+# -----------------------------------------------------------------------------
+def AddInput(section, name, address, size, obj):
+    size = int(size, 16)
+    if size == 0:
+        return
+    obj = obj.strip().replace('\\', '/').split('/')[-1]
+    section['inputs'].append({'name': name, 'address': int(address, 16),
+                              'size': size, 'object': obj, 'symbols': []})
+
+
+# -----------------------------------------------------------------------------
+# Prints the report, returns the list of missing ITCM functions
+# -----------------------------------------------------------------------------
+def Report(regions, sections):
+    print('Tightly coupled memory placement')
+    print('=' * 78)
+    for name, region in SECTIONS.items():
+        sec = sections[name]
+        length = regions.get(region, (0, 0))[1]
+        usage = '{:6.1f} %'.format(100.0 * sec['size'] / length) if length else '      ?'
+        print('{:<18} {:>8} bytes  in {:<8} {}'.format(name, sec['size'], region, usage))
+        print('-' * 78)
+        for i in sorted(sec['inputs'], key=lambda i: -i['size']):
+            label = i['symbols'][0] if i['symbols'] else i['name']
+            print('  0x{:08x} {:>7}  {:<20} {}'.format(i['address'], i['size'], i['object'], label))
+        print()
+
+    placed = set()
+    for i in sections['.itcm_text']['inputs']:
+        placed.update(i['symbols'])
+        placed.add(i['name'].replace('.text.', ''))
+    missing = [f for f in ITCM_EXPECTED if f not in placed]
+    for f in missing:
+        print('warning: {} is not in ITCM (check the .itcm_text patterns of the linker script)'.format(f))
+    return missing
+
+
+# =============================================================================
+# Main
+# =============================================================================
+if __name__ == '__main__':
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    if len(args) != 1:
+        print('usage: MemoryReport.py <project>.map [--strict]')
+        sys.exit(2)
+    missing = Report(*ParseMap(args[0]))
+    sys.exit(1 if missing and '--strict' in sys.argv else 0)
+
+#***End of file**************************************************************